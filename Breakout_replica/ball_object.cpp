@@ -11,7 +11,7 @@
 BallObject::BallObject()
 	: GameObject(),Radius(12.5f), Stuck(true){}
 
-BallObject::BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, Texture2D sprite)
+BallObject::BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, TextureHandle sprite)
 	: GameObject(pos, glm::vec2(radius * 2, radius * 2), sprite, glm::vec3(1.0f), velocity), Radius(radius), Stuck(true) {}
 
 glm::vec2 BallObject::Move(float dt, unsigned int window_width) {
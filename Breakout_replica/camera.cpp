@@ -0,0 +1,52 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "camera.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+Camera2D::Camera2D(glm::vec2 viewSize)
+    : Position(0.0f), ViewSize(viewSize), Zoom(1.0f) { }
+
+glm::vec2 Camera2D::Size() const
+{
+    return this->ViewSize / this->Zoom;
+}
+
+void Camera2D::Follow(glm::vec2 target, glm::vec2 worldSize)
+{
+    glm::vec2 size = this->Size();
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (worldSize[axis] > size[axis])
+            this->Position[axis] = glm::clamp(target[axis] - size[axis] / 2.0f, 0.0f, worldSize[axis] - size[axis]);
+        else
+            this->Position[axis] = (worldSize[axis] - size[axis]) / 2.0f;
+    }
+}
+
+void Camera2D::SetZoom(float zoom)
+{
+    this->Zoom = std::clamp(zoom, MIN_ZOOM, MAX_ZOOM);
+}
+
+bool Camera2D::Visible(glm::vec2 position, glm::vec2 size) const
+{
+    glm::vec2 max = this->Position + this->Size();
+    return position.x < max.x && position.x + size.x > this->Position.x
+        && position.y < max.y && position.y + size.y > this->Position.y;
+}
+
+glm::mat4 Camera2D::Projection() const
+{
+    glm::vec2 max = this->Position + this->Size();
+    return glm::ortho(this->Position.x, max.x, max.y, this->Position.y, -1.0f, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm/glm.hpp>
+
+
+// Camera2D is the part of the game's world shown on screen. The view is
+// ViewSize / Zoom world units large with its top-left corner at Position;
+// Follow() scrolls it towards a target while keeping it inside the world
+// (a world smaller than the view is centered instead). Its projection
+// replaces the fixed screen-sized projection of the world's shaders and
+// Visible() culls objects against the view.
+class Camera2D
+{
+public:
+    // zoom limits, below 1 more than a screen of the world is shown
+    static constexpr float MIN_ZOOM = 0.5f;
+    static constexpr float MAX_ZOOM = 2.0f;
+    // top-left corner of the view in world units
+    glm::vec2 Position;
+    // size of the view at zoom 1, the game's screen size
+    glm::vec2 ViewSize;
+    // magnification of the view
+    float     Zoom;
+    // constructor
+    Camera2D(glm::vec2 viewSize);
+    // size of the world area in view
+    glm::vec2 Size() const;
+    // centers the view on target, kept inside a world of the given size
+    void      Follow(glm::vec2 target, glm::vec2 worldSize);
+    // changes the zoom, limited to [MIN_ZOOM, MAX_ZOOM]
+    void      SetZoom(float zoom);
+    // returns true if the area (in world units) overlaps the view
+    bool      Visible(glm::vec2 position, glm::vec2 size) const;
+    // orthographic projection of the view, y pointing down
+    glm::mat4 Projection() const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_graph.h"
+#include "state_cache.h"
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+bool TargetDesc::operator==(const TargetDesc& other) const
+{
+    return this->Width == other.Width && this->Height == other.Height && this->Samples == other.Samples && this->InternalFormat == other.InternalFormat;
+}
+
+unsigned int FrameGraph::PassContext::Texture(Resource input) const
+{
+    const ResourceNode& node = this->graph->resources[input];
+    if (node.Imported)
+        return node.Texture;
+    int target = node.Desc.Samples > 1 ? node.Resolved : node.Target;
+    return target < 0 ? 0 : this->graph->pool[target].Texture;
+}
+
+FrameGraph::FrameGraph()
+    : Profiler(nullptr), frame(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    this->Clear();
+}
+
+void FrameGraph::Reset()
+{
+    // the vectors keep their storage, so declaring a frame doesn't allocate once warmed up
+    this->resources.clear();
+    this->passes.clear();
+    this->inputs.clear();
+}
+
+FrameGraph::Resource FrameGraph::ImportBackbuffer(unsigned int width, unsigned int height)
+{
+    return this->ImportTarget(0, 0, { width, height, 1, GL_RGB });
+}
+
+FrameGraph::Resource FrameGraph::ImportTarget(unsigned int framebuffer, unsigned int texture, const TargetDesc& desc)
+{
+    this->resources.push_back({ desc, true, true, -1, -1, -1, framebuffer, texture });
+    return static_cast<Resource>(this->resources.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::CreateTarget(const TargetDesc& desc)
+{
+    this->resources.push_back({ desc, false, false, -1, -1, -1, 0, 0 });
+    return static_cast<Resource>(this->resources.size() - 1);
+}
+
+void FrameGraph::AddPass(const char* name, std::initializer_list<Resource> inputs, Resource output, PassFunction execute)
+{
+    unsigned int first = static_cast<unsigned int>(this->inputs.size());
+    this->inputs.insert(this->inputs.end(), inputs.begin(), inputs.end());
+    this->passes.push_back({ name, first, static_cast<unsigned int>(inputs.size()), output, std::move(execute) });
+}
+
+void FrameGraph::Execute()
+{
+    ++this->frame;
+    // walk the passes backwards: a pass is live if something needs its output, which in turn makes its inputs needed
+    std::size_t passCount = this->passes.size();
+    for (std::size_t i = passCount; i-- > 0; )
+    {
+        PassNode& pass = this->passes[i];
+        if (!this->resources[pass.Output].Needed)
+        {
+            pass.Output = -1; // culled
+            continue;
+        }
+        for (unsigned int j = 0; j < pass.InputCount; ++j)
+        {
+            ResourceNode& input = this->resources[this->inputs[pass.FirstInput + j]];
+            input.Needed = true;
+            input.LastUse = std::max(input.LastUse, static_cast<int>(i));
+        }
+        ResourceNode& output = this->resources[pass.Output];
+        output.LastUse = std::max(output.LastUse, static_cast<int>(i));
+    }
+    // run the live passes, allocating targets on first use and resolving multisampled inputs
+    PassContext context;
+    context.graph = this;
+    for (std::size_t i = 0; i < passCount; ++i)
+    {
+        PassNode& pass = this->passes[i];
+        if (pass.Output < 0)
+            continue;
+        for (unsigned int j = 0; j < pass.InputCount; ++j)
+        {
+            ResourceNode& input = this->resources[this->inputs[pass.FirstInput + j]];
+            if (!input.Imported && input.Desc.Samples > 1 && input.Resolved < 0 && input.Target >= 0)
+            {
+                TargetDesc resolvedDesc = input.Desc;
+                resolvedDesc.Samples = 1;
+                input.Resolved = this->acquire(resolvedDesc);
+                GpuProfiler::Scope scope(this->Profiler, "resolve");
+                StateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, this->pool[input.Target].FBO);
+                StateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, this->pool[input.Resolved].FBO);
+                glBlitFramebuffer(0, 0, input.Desc.Width, input.Desc.Height, 0, 0, input.Desc.Width, input.Desc.Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+        }
+        ResourceNode& output = this->resources[pass.Output];
+        if (output.Imported)
+            StateCache::BindFramebuffer(GL_FRAMEBUFFER, output.FBO);
+        else if (output.Target < 0)
+        {
+            output.Target = this->acquire(output.Desc);
+            StateCache::BindFramebuffer(GL_FRAMEBUFFER, this->pool[output.Target].FBO);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        else
+            StateCache::BindFramebuffer(GL_FRAMEBUFFER, this->pool[output.Target].FBO);
+        glViewport(0, 0, output.Desc.Width, output.Desc.Height);
+        context.Width = output.Desc.Width;
+        context.Height = output.Desc.Height;
+        {
+            GpuProfiler::Scope scope(this->Profiler, pass.Name);
+            pass.Execute(context);
+        }
+        // targets whose last use was this pass can be handed to the following passes
+        for (ResourceNode& resource : this->resources)
+        {
+            if (resource.LastUse != static_cast<int>(i))
+                continue;
+            if (resource.Target >= 0)
+                this->release(resource.Target);
+            if (resource.Resolved >= 0)
+                this->release(resource.Resolved);
+            resource.Target = resource.Resolved = -1;
+        }
+    }
+    // release pooled targets that haven't been needed for a while
+    for (Target& target : this->pool)
+        if (target.FBO != 0 && this->frame - target.LastUsedFrame > RETIRE_FRAMES)
+            this->destroy(target);
+}
+
+void FrameGraph::Clear()
+{
+    for (Target& target : this->pool)
+        this->destroy(target);
+    this->pool.clear();
+}
+
+int FrameGraph::acquire(const TargetDesc& desc)
+{
+    int slot = -1;
+    for (std::size_t i = 0; i < this->pool.size(); ++i)
+    {
+        Target& target = this->pool[i];
+        if (target.FBO != 0 && !target.InUse && target.Desc == desc)
+        {
+            target.InUse = true;
+            target.LastUsedFrame = this->frame;
+            return static_cast<int>(i);
+        }
+        if (target.FBO == 0 && slot < 0)
+            slot = static_cast<int>(i); // released earlier, reuse the entry
+    }
+    if (slot < 0)
+    {
+        this->pool.push_back({ desc, 0, 0, 0, false, 0 });
+        slot = static_cast<int>(this->pool.size() - 1);
+    }
+    Target& target = this->pool[slot];
+    target.Desc = desc;
+    target.InUse = true;
+    target.LastUsedFrame = this->frame;
+    glGenFramebuffers(1, &target.FBO);
+    StateCache::BindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+    if (desc.Samples > 1)
+    {
+        glGenRenderbuffers(1, &target.RBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.RBO);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.Samples, desc.InternalFormat, desc.Width, desc.Height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.RBO);
+    }
+    else
+    {
+        glGenTextures(1, &target.Texture);
+        StateCache::BindTexture(GL_TEXTURE_2D, target.Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.InternalFormat, desc.Width, desc.Height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        // repeat like any other texture, the chaos effect samples beyond the scene's edges
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.Texture, 0);
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEGRAPH: Failed to initialize render target" << std::endl;
+    return slot;
+}
+
+void FrameGraph::release(int target)
+{
+    this->pool[target].InUse = false;
+}
+
+void FrameGraph::destroy(Target& target)
+{
+    if (target.FBO == 0)
+        return;
+    glDeleteFramebuffers(1, &target.FBO);
+    if (target.RBO != 0)
+        glDeleteRenderbuffers(1, &target.RBO);
+    if (target.Texture != 0)
+        glDeleteTextures(1, &target.Texture);
+    target.FBO = target.RBO = target.Texture = 0;
+    target.InUse = false;
+    // deleted objects were unbound by the context behind the state cache's back
+    StateCache::Invalidate();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include <glad/glad.h>
+
+class GpuProfiler;
+
+
+// Describes a render target requested from the frame graph
+struct TargetDesc {
+    unsigned int Width, Height;
+    unsigned int Samples;        // 1 for a texture, more for a multisampled renderbuffer
+    GLenum       InternalFormat;
+    bool operator==(const TargetDesc& other) const;
+};
+
+
+// FrameGraph sequences the render passes of a frame. Every frame the
+// passes are declared again together with the targets they read and the
+// target they render to; Execute() then culls passes whose output nobody
+// uses, allocates the transient targets from a pool (targets whose last
+// use has passed are handed to later passes, so they alias), resolves
+// multisampled targets before a pass samples them and runs the passes in
+// order. Pooled targets that go unused for a while are released again.
+// Targets owned outside the graph (the backbuffer, retained layers) are
+// imported; their contents persist, so passes writing them are never
+// culled and they're never cleared.
+// If a Profiler is set, every pass (and resolve) is timed in a scope
+// named after it.
+class FrameGraph
+{
+public:
+    // handle of a target within the current frame
+    typedef int Resource;
+    // gives a pass access to the targets it declared
+    class PassContext
+    {
+    public:
+        // returns the texture holding the contents of an input (resolved if it's multisampled)
+        unsigned int Texture(Resource input) const;
+        // size of the pass' output
+        unsigned int Width, Height;
+    private:
+        friend class FrameGraph;
+        const FrameGraph* graph;
+    };
+    typedef std::function<void(const PassContext&)> PassFunction;
+    // times the passes if set
+    GpuProfiler* Profiler;
+    // constructor/destructor
+    FrameGraph();
+    ~FrameGraph();
+    // starts declaring a new frame
+    void Reset();
+    // declares the default framebuffer as a target the frame must end up in
+    Resource ImportBackbuffer(unsigned int width, unsigned int height);
+    // declares a target owned outside the graph: passes render into framebuffer and later passes sample texture
+    Resource ImportTarget(unsigned int framebuffer, unsigned int texture, const TargetDesc& desc);
+    // declares a transient target that only lives during this frame; it's cleared to black before it's first rendered to
+    Resource CreateTarget(const TargetDesc& desc);
+    // declares a pass that samples the inputs and renders into the output
+    void AddPass(const char* name, std::initializer_list<Resource> inputs, Resource output, PassFunction execute);
+    // culls, allocates and runs all passes declared since Reset
+    void Execute();
+    // releases all pooled targets
+    void Clear();
+private:
+    struct ResourceNode {
+        TargetDesc   Desc;
+        bool         Imported;
+        bool         Needed;
+        int          LastUse;      // index of the last live pass using the resource
+        int          Target;       // pooled target holding the contents (-1 if not allocated)
+        int          Resolved;     // pooled single-sample copy of a multisampled target (-1 if not resolved)
+        unsigned int FBO, Texture; // storage of imported targets
+    };
+    struct PassNode {
+        const char*  Name;
+        unsigned int FirstInput, InputCount; // range in inputs
+        Resource     Output;
+        PassFunction Execute;
+    };
+    struct Target {
+        TargetDesc   Desc;
+        unsigned int FBO;
+        unsigned int RBO;     // storage of multisampled targets
+        unsigned int Texture; // storage of single-sample targets
+        bool         InUse;
+        unsigned int LastUsedFrame;
+    };
+    // frames a pooled target may go unused before it's released
+    static const unsigned int RETIRE_FRAMES = 120;
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode>     passes;
+    std::vector<Resource>     inputs;
+    std::vector<Target>       pool;
+    unsigned int              frame;
+    // hands out a free pooled target matching desc, creating one if necessary
+    int acquire(const TargetDesc& desc);
+    // returns a target to the pool so later passes can reuse it
+    void release(int target);
+    // frees the GPU storage of a pooled target
+    void destroy(Target& target);
+};
+
+#endif
\ No newline at end of file
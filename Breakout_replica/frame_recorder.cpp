@@ -0,0 +1,250 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_recorder.h"
+#include "state_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// longest wait for a readback before giving up on it (in nanoseconds)
+const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+// full range BT.601 (as in JPEG) in 8-bit fixed point
+static unsigned char luma(int r, int g, int b)
+{
+    return static_cast<unsigned char>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+static unsigned char chroma(int r, int g, int b, int cr, int cg, int cb)
+{
+    return static_cast<unsigned char>(std::clamp((cr * r + cg * g + cb * b + 32896) >> 8, 0, 255));
+}
+
+
+FrameRecorder::FrameRecorder()
+    : nextReadback(0), width(0), height(0), recording(false), startTime(0.0f), framesDue(0), captures(0), captureTime(0.0), stopping(false), dropped(0), output(nullptr)
+{
+    for (Readback& readback : this->readbacks)
+    {
+        glGenBuffers(1, &readback.PBO);
+        readback.Fence = nullptr;
+        readback.Repeat = 0;
+    }
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    this->Stop();
+    for (Readback& readback : this->readbacks)
+        glDeleteBuffers(1, &readback.PBO);
+}
+
+bool FrameRecorder::Start(const std::string& file, unsigned int width, unsigned int height)
+{
+    this->Stop();
+    this->output = std::fopen(file.c_str(), "wb");
+    if (!this->output)
+    {
+        std::cout << "ERROR::RECORDER: Failed to create " << file << std::endl;
+        return false;
+    }
+    std::fprintf(this->output, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, FRAME_RATE);
+    for (Readback& readback : this->readbacks)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->file = file;
+    this->width = width;
+    this->height = height;
+    this->nextReadback = 0;
+    this->framesDue = 0;
+    this->captures = 0;
+    this->captureTime = 0.0;
+    this->stopping = false;
+    this->dropped = 0;
+    this->encoder = std::thread(&FrameRecorder::encode, this);
+    this->recording = true;
+    std::cout << "Recording to " << file << " (F9 stops)" << std::endl;
+    return true;
+}
+
+void FrameRecorder::Stop()
+{
+    if (!this->recording)
+        return;
+    this->recording = false;
+    // the frames still being read back, oldest first
+    for (unsigned int i = 0; i < READBACK_COUNT; ++i)
+    {
+        Readback& readback = this->readbacks[(this->nextReadback + i) % READBACK_COUNT];
+        if (!readback.Fence)
+            continue;
+        glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        this->collect(readback);
+    }
+    // the encoder finishes the queued frames before it stops
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->encoder.join();
+    std::fclose(this->output);
+    this->output = nullptr;
+    std::cout << "Recorded " << this->framesDue << " frames to " << this->file << " (" << this->dropped << " dropped), capturing took "
+        << (this->captures > 0 ? this->captureTime / this->captures : 0.0) << " ms per frame" << std::endl;
+}
+
+bool FrameRecorder::Recording() const
+{
+    return this->recording;
+}
+
+void FrameRecorder::Capture(float time, unsigned int width, unsigned int height)
+{
+    if (!this->recording)
+        return;
+    if (width != this->width || height != this->height)
+    {
+        std::cout << "Recording stopped, the window was resized" << std::endl;
+        this->Stop();
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // the frame is shown for the video frames that start from the previous capture up to now
+    if (this->captures == 0)
+        this->startTime = time;
+    unsigned int due = static_cast<unsigned int>(std::lround((time - this->startTime) * FRAME_RATE)) + 1;
+    if (due <= this->framesDue)
+        return; // rendering faster than the video's frame rate
+    // the buffer's previous frame was read back READBACK_COUNT frames ago, its copy is normally done
+    Readback& readback = this->readbacks[this->nextReadback];
+    if (readback.Fence)
+    {
+        glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        this->collect(readback);
+    }
+    this->nextReadback = (this->nextReadback + 1) % READBACK_COUNT;
+    // copy the default framebuffer into the PBO, glReadPixels returns right away; BGRA is what drivers copy fastest
+    StateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, this->width, this->height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.Repeat = due - this->framesDue;
+    this->framesDue = due;
+    ++this->captures;
+    this->captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrameRecorder::collect(Readback& readback)
+{
+    glDeleteSync(readback.Fence);
+    readback.Fence = nullptr;
+    Frame frame;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->queue.size() >= MAX_QUEUED)
+        {
+            // the encoder can't keep up: show the newest queued frame longer so the video stays in time
+            this->queue.back().Repeat += readback.Repeat;
+            ++this->dropped;
+            return;
+        }
+        if (!this->unused.empty())
+        {
+            frame = std::move(this->unused.back());
+            this->unused.pop_back();
+        }
+    }
+    std::size_t size = static_cast<std::size_t>(this->width) * this->height * 4;
+    frame.Pixels.resize(size);
+    frame.Repeat = readback.Repeat;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (data)
+    {
+        std::memcpy(frame.Pixels.data(), data, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queue.push_back(std::move(frame));
+    }
+    this->wake.notify_one();
+}
+
+void FrameRecorder::encode()
+{
+    std::vector<unsigned char> yuv;
+    for (;;)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+            if (this->queue.empty())
+                return; // stopping and all frames are written
+            frame = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+        this->write(frame, yuv);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->unused.push_back(std::move(frame));
+        }
+    }
+}
+
+void FrameRecorder::write(const Frame& frame, std::vector<unsigned char>& yuv)
+{
+    // a full size luma plane followed by the chroma planes at half the size in both directions
+    unsigned int width = this->width, height = this->height;
+    unsigned int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    yuv.resize(width * height + 2 * chromaWidth * chromaHeight);
+    unsigned char* y = yuv.data();
+    unsigned char* u = y + width * height;
+    unsigned char* v = u + chromaWidth * chromaHeight;
+    // OpenGL's rows start at the bottom, the video's at the top
+    const unsigned char* pixels = frame.Pixels.data();
+    std::size_t stride = static_cast<std::size_t>(width) * 4;
+    for (unsigned int row = 0; row < height; ++row)
+    {
+        const unsigned char* bgra = pixels + (height - 1 - row) * stride;
+        for (unsigned int x = 0; x < width; ++x, bgra += 4)
+            *y++ = luma(bgra[2], bgra[1], bgra[0]);
+    }
+    // chroma of the average of every 2x2 pixels (repeating the last row and column if the size is odd)
+    for (unsigned int row = 0; row < chromaHeight; ++row)
+    {
+        const unsigned char* top = pixels + (height - 1 - 2 * row) * stride;
+        const unsigned char* bottom = pixels + (height - 1 - std::min(2 * row + 1, height - 1)) * stride;
+        for (unsigned int x = 0; x < chromaWidth; ++x)
+        {
+            std::size_t left = 2 * x * 4, right = std::min(2 * x + 1, width - 1) * 4;
+            int b = (top[left] + top[right] + bottom[left] + bottom[right] + 2) / 4;
+            int g = (top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1] + 2) / 4;
+            int r = (top[left + 2] + top[right + 2] + bottom[left + 2] + bottom[right + 2] + 2) / 4;
+            *u++ = chroma(r, g, b, -43, -85, 128);
+            *v++ = chroma(r, g, b, 128, -107, -21);
+        }
+    }
+    for (unsigned int i = 0; i < frame.Repeat; ++i)
+    {
+        std::fputs("FRAME\n", this->output);
+        std::fwrite(yuv.data(), 1, yuv.size(), this->output);
+    }
+}
\ No newline at end of file
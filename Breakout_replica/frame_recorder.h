@@ -0,0 +1,94 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// FrameRecorder records the rendered frames into a Y4M video (raw 4:2:0
+// YUV that ffmpeg and most players read directly) without stalling the
+// pipeline. Each frame is read back from the default framebuffer into a
+// ring of READBACK_COUNT pixel buffer objects; a buffer is only mapped
+// when it comes around again, READBACK_COUNT frames later, by which time
+// the copy has long finished. The pixels are then handed to an encoder
+// thread that converts them and writes the file, so the render thread
+// only pays for starting the readback and one memcpy per frame. If the
+// encoder falls more than MAX_QUEUED frames behind, frames are dropped
+// rather than waited for.
+//
+// The video has a fixed FRAME_RATE: frames rendered faster are skipped
+// and slow frames are repeated, so a clip plays back in real time.
+class FrameRecorder
+{
+public:
+    // frames per second of the video
+    static const unsigned int FRAME_RATE = 60;
+    // frames read back at once
+    static const unsigned int READBACK_COUNT = 3;
+    // most frames waiting for the encoder
+    static const unsigned int MAX_QUEUED = 8;
+    // constructor/destructor, stops recording
+    FrameRecorder();
+    ~FrameRecorder();
+    // starts recording a width x height framebuffer into file; returns false if the file can't be created
+    bool Start(const std::string& file, unsigned int width, unsigned int height);
+    // stops recording, finishing the frames still being read back or encoded
+    void Stop();
+    // returns true while recording
+    bool Recording() const;
+    // records the default framebuffer as the frame at time (in seconds, any origin); call it after
+    // rendering and before swapping buffers. Stops recording if the framebuffer's size changed
+    void Capture(float time, unsigned int width, unsigned int height);
+private:
+    struct Readback {
+        unsigned int PBO;
+        GLsync       Fence;  // passed once the copy into the PBO is done (nullptr if unused)
+        unsigned int Repeat; // video frames it's shown for
+    };
+    struct Frame {
+        std::vector<unsigned char> Pixels; // BGRA, rows from the bottom up
+        unsigned int               Repeat;
+    };
+    // used on the render thread only
+    Readback     readbacks[READBACK_COUNT];
+    unsigned int nextReadback;
+    unsigned int width, height;
+    bool         recording;
+    float        startTime;
+    unsigned int framesDue;     // video frames up to the last capture
+    unsigned int captures;
+    double       captureTime;   // milliseconds spent in Capture
+    std::string  file;
+    // shared with the encoder, guarded by mutex
+    std::mutex              mutex;
+    std::condition_variable wake;    // a frame was queued or the recording stops
+    std::deque<Frame>       queue;
+    std::vector<Frame>      unused;  // frames to reuse, saves reallocating their pixels
+    bool                    stopping;
+    unsigned int            dropped;
+    std::FILE*              output;
+    std::thread             encoder;
+    // maps a finished readback and queues its pixels for the encoder
+    void collect(Readback& readback);
+    // loop of the encoder thread
+    void encode();
+    // writes a frame to the file as YUV
+    void write(const Frame& frame, std::vector<unsigned char>& yuv);
+};
+
+#endif
\ No newline at end of file
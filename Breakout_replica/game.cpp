@@ -8,557 +8,238 @@
 ******************************************************************/
 #include "game.h"
 #include "resource_manager.h"
-#include "sprite_renderer.h"
-#include "ball_object.h"
-#include "particle_generator.h"
-#include "post_processor.h"
-#include "text_renderer.h"
+#include "state_cache.h"
+#include "gpu_profiler.h"
+#include "frame_recorder.h"
 
-#include <iostream>
+#include <algorithm>
 #include <sstream>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <filesystem>
 #include <irrKlang.h>
 
 using namespace irrklang;
-ISoundEngine* SoundEngine = createIrrKlangDevice();
+// falls back to irrKlang's silent driver on machines without an audio device (e.g. headless runs)
+static ISoundEngine* createSoundEngine() {
+	ISoundEngine* engine = createIrrKlangDevice();
+	return engine ? engine : createIrrKlangDevice(ESOD_NULL);
+}
+ISoundEngine* SoundEngine = createSoundEngine();
 
+// shared by all sessions
 SpriteRenderer* Renderer;
-
-// Initial size of the player paddle
-const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
-// Initial velocity of the player paddle
-const float PLAYER_VELOCITY(500.0f);
-// player paddle
-GameObject* Player;
-// Initial velocity of the Ball
-const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
-// Radius of the ball object
-const float BALL_RADIUS = 12.5f;
-
-struct InitialValue {
-	glm::vec2 playerSize = PLAYER_SIZE;
-	glm::vec2 ballVelocity = INITIAL_BALL_VELOCITY;
-};
-
-struct InitialValue initialValue;
-// Ball
-BallObject* Ball;
-PostProcessor* Effects;
+// the scene's draws, sorted by layer and then by state
+RenderQueue* Queue;
 TextRenderer* Text;
-ParticleGenerator* Particles;
-float ShakeTime = 0.0f;
+// brick appearances
+MaterialLibrary* Materials;
+FrameGraph* Graph;
+GpuProfiler* Profiler;
+// gameplay videos (toggled with F9)
+FrameRecorder* Recorder;
+
+// milliseconds per frame spent uploading textures loaded in the background
+const float TEXTURE_UPLOAD_BUDGET = 2.0f;
+
+// bound to a reference by std::clamp, so it needs a definition
+const unsigned int Game::MAX_SESSIONS;
+
+// keys of each session, in the order sessions are added
+const SessionControls SESSION_CONTROLS[Game::MAX_SESSIONS] = {
+	{ GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_SPACE, GLFW_KEY_M, GLFW_KEY_ENTER, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_E, GLFW_KEY_Q, "m", "ENTER", "W or S" },
+	{ GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_END, GLFW_KEY_HOME, GLFW_KEY_PAGE_UP, GLFW_KEY_PAGE_DOWN, GLFW_KEY_INSERT, GLFW_KEY_DELETE, "END", "HOME", "PGUP or PGDN" },
+	{ GLFW_KEY_J, GLFW_KEY_L, GLFW_KEY_I, GLFW_KEY_N, GLFW_KEY_H, GLFW_KEY_O, GLFW_KEY_U, GLFW_KEY_P, GLFW_KEY_Y, "n", "H", "O or U" },
+	{ GLFW_KEY_KP_4, GLFW_KEY_KP_6, GLFW_KEY_KP_8, GLFW_KEY_KP_0, GLFW_KEY_KP_ENTER, GLFW_KEY_KP_9, GLFW_KEY_KP_3, GLFW_KEY_KP_ADD, GLFW_KEY_KP_SUBTRACT, "NUM 0", "NUM ENTER", "NUM 9 or 3" }
+};
 
 Game::Game(unsigned int width, unsigned int height)
-	: State(GAME_MENU), Keys(), Width(width), Height(height) {
+	: Keys(), KeysProcessed(), Width(width), Height(height), FramebufferWidth(width), FramebufferHeight(height), SessionCount(1), RenderScale(1.0f), ShowStats(false), Time(0.0f) {
+	this->Resize(width, height);
 }
 
 Game::~Game() {
-	delete Renderer;
-	delete Player;
-	delete Ball;
-	delete Particles;
-	delete Effects;
+	this->Shutdown();
 }
 
 void Game::Init() {
+	// load textures, they're decoded in the background while the rest loads
+	ResourceManager::LoadTextureAsync("resources/textures/background.jpg", false, "background");
+	ResourceManager::LoadTextureAsync("resources/textures/paddle.png", true, "paddle");
+	ResourceManager::LoadTextureAsync("resources/textures/awesomeface.png", true, "ball");
+	ResourceManager::LoadTextureAsync("resources/textures/particle.png", true, "particle");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_speed.png", true, "powerup_speed");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_chaos.png", true, "powerup_chaos");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_confuse.png", true, "powerup_confuse");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_increase.png", true, "powerup_increase");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_passthrough.png", true, "powerup_passthrough");
+	ResourceManager::LoadTextureAsync("resources/textures/powerup_sticky.png", true, "powerup_sticky");
 	// load shaders
 	ResourceManager::LoadShader("shaders/sprite.vs", "shaders/sprite.frag", nullptr, "sprite");
 	ResourceManager::LoadShader("shaders/particle.vs", "shaders/particle.frag", nullptr, "particle");
-	ResourceManager::LoadShader("shaders/post_processing.vs", "shaders/post_processing.frag", nullptr, "postprocessing");
+	std::string materialDefines = "#define MAX_MATERIALS " + std::to_string(MaterialLibrary::MAX_MATERIALS) + "\n";
+	ResourceManager::LoadShader("shaders/brick.vs", "shaders/brick.frag", nullptr, "brick", materialDefines.c_str());
+	const char* particleVaryings[] = { "outPosition", "outVelocity", "outColor", "outLife" };
+	ResourceManager::LoadTransformFeedbackShader("shaders/particle_update.vs", particleVaryings, 4, "particle_update");
 	// configure shaders
 	glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width), static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
 	ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
 	ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
 	ResourceManager::GetShader("particle").Use().SetInteger("sprite", 0);
 	ResourceManager::GetShader("particle").SetMatrix4("projection", projection);
+	Shader brickShader = ResourceManager::GetShader("brick");
+	brickShader.Use().SetInteger("layers", 0);
+	brickShader.SetMatrix4("projection", projection);
+	glUniformBlockBinding(brickShader.ID, glGetUniformBlockIndex(brickShader.ID, "Materials"), MaterialLibrary::BINDING);
 	// set render-specific controls
 	Shader spriteShader = ResourceManager::GetShader("sprite");
 	Renderer = new SpriteRenderer(spriteShader);
-	Effects = new PostProcessor(ResourceManager::GetShader("postprocessing"), this->Width, this->Height);
-	// load textures
-	ResourceManager::LoadTexture("resources/textures/background.jpg", false, "background");
-	ResourceManager::LoadTexture("resources/textures/paddle.png", true, "paddle");
-	ResourceManager::LoadTexture("resources/textures/block.png", false, "block");
-	ResourceManager::LoadTexture("resources/textures/block_solid.png", false, "block_solid");
-	ResourceManager::LoadTexture("resources/textures/awesomeface.png", true, "ball");
-	ResourceManager::LoadTexture("resources/textures/particle.png", true, "particle");
-	ResourceManager::LoadTexture("resources/textures/powerup_speed.png", true, "powerup_speed");
-	ResourceManager::LoadTexture("resources/textures/powerup_chaos.png", true, "powerup_chaos");
-	ResourceManager::LoadTexture("resources/textures/powerup_confuse.png", true, "powerup_confuse");
-	ResourceManager::LoadTexture("resources/textures/powerup_increase.png", true, "powerup_increase");
-	ResourceManager::LoadTexture("resources/textures/powerup_passthrough.png", true, "powerup_passthrough");
-	ResourceManager::LoadTexture("resources/textures/powerup_sticky.png", true, "powerup_sticky");
-	// load levels
-	for (const auto& entry : std::filesystem::directory_iterator("levels")) {
-		GameLevel level; level.Load(entry.path().string().c_str(), this->Width, this->Height / 2);
-		this->Levels.push_back(level);
-	}
-	this->Level = 0;
-	// load player
-	glm::vec2 playerPos = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
-	Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::GetTexture("paddle"));
-	// load ball 
-	glm::vec2 ballPos = glm::vec2(this->Width / 2.0f - BALL_RADIUS, this->Height - PLAYER_SIZE.y - BALL_RADIUS * 2);
-	Ball = new BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY, ResourceManager::GetTexture("ball"));
-	Ball->Sticky = false;
-	Ball->PassThrough = false;
-	this->Lives = 3;
-	// initialize particles
-	Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), 500);
+	Queue = new RenderQueue(*Renderer, spriteShader.ID);
+	Graph = new FrameGraph();
+	Profiler = new GpuProfiler();
+	Graph->Profiler = Profiler;
+	Recorder = new FrameRecorder();
+	// the bricks' textures are layers of the materials' array texture
+	Materials = new MaterialLibrary();
+	Materials->Load("resources/materials.txt", "resources/textures");
 	// load background sound
 	SoundEngine->play2D("resources/audios/background.mp3", true);
 	// load font
 	Text = new TextRenderer(this->Width, this->Height);
-	Text->Load("resources/fonts/ocraext.TTF", 24);
+	Text->Load("resources/fonts/OCRAEXT.TTF", 24);
+	// the sessions take their textures when they're created
+	ResourceManager::FinishTextures();
+	// create the sessions, they share everything loaded so far
+	this->SessionCount = std::clamp(this->SessionCount, 1u, MAX_SESSIONS);
+	for (unsigned int i = 0; i < this->SessionCount; ++i) {
+		GameSession* session = new GameSession(i, this->Width, this->Height, SESSION_CONTROLS[i], Renderer, Queue, Text, Materials, SoundEngine);
+		session->Init();
+		this->Sessions.push_back(session);
+	}
+	this->Resize(this->FramebufferWidth, this->FramebufferHeight);
 }
 
 void Game::Update(float dt) {
-	if (this->State == GAME_ACTIVE) {
-		// update objects
-		Ball->Move(dt, this->Width);
-		// check for collisions
-		this->DoCollisions();
-		// ball hit the bottom edge
-		if (Ball->Position.y >= this->Height) {
-			SoundEngine->play2D("resources/audios/hurtPlayer.wav", false);
-			--this->Lives;
-			// did the player lose all his lives? : Game over
-			if (this->Lives == 0)
-			{
-				this->Lives = 3;
-				this->ResetLevel();
-				this->State = GAME_MENU;
-				Particles->Reset();
-			}
-			this->ResetPlayer();
-		}
-		// update particle
-		Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2.0f));
-		// update PowerUps
-		this->UpdatePowerUps(dt);
-		if (ShakeTime > 0.0f)
-		{
-			ShakeTime -= dt;
-			if (ShakeTime <= 0.0f)
-				Effects->Shake = false;
-		}
-
-		if (this->Levels[this->Level].IsCompleted())
-		{
-			Effects->Chaos = true;
-			this->State = GAME_WIN;
-			this->Lives = 3;
-			Player->Size = initialValue.playerSize;
-			Player->Velocity = initialValue.ballVelocity;
-		}
-	}
+	this->Time += dt;
+	for (GameSession* session : this->Sessions)
+		session->Update(dt);
+}
+
+void Game::Shutdown() {
+	// the recorder first, it reads back the frames still in flight
+	delete Recorder;
+	Recorder = nullptr;
+	for (GameSession* session : this->Sessions)
+		delete session;
+	this->Sessions.clear();
+	delete Renderer;
+	delete Queue;
+	delete Text;
+	delete Materials;
+	delete Graph;
+	delete Profiler;
+	Renderer = nullptr;
+	Queue = nullptr;
+	Text = nullptr;
+	Materials = nullptr;
+	Graph = nullptr;
+	Profiler = nullptr;
 }
 
 void Game::ProcessInput(float dt) {
-	if (this->State == GAME_ACTIVE) {
-		float velocity = PLAYER_VELOCITY * dt;
-		// move playerboard
-		if (this->Keys[GLFW_KEY_A]) {
-			if (Player->Position.x > 0.0f) {
-				Player->Position.x -= velocity;
-				if (Ball->Stuck)
-					Ball->Position.x -= velocity;
-			}
-		}
-		if (this->Keys[GLFW_KEY_D]) {
-			if (Player->Position.x < this->Width - Player->Size.x) {
-				Player->Position.x += velocity;
-				if (Ball->Stuck)
-					Ball->Position.x += velocity;
-			}
-		}
-		if (this->Keys[GLFW_KEY_SPACE]) {
-			Ball->Stuck = false;
-		}
-		if (this->Keys[GLFW_KEY_M]) {
-			this->State = GAME_MENU;
-		}
-	}
-	else if (this->State == GAME_MENU) {
-		SoundEngine->setSoundVolume(0.5f);
-		if (this->Keys[GLFW_KEY_ENTER] && !this->KeysProcessed[GLFW_KEY_ENTER]) {
-			this->KeysProcessed[GLFW_KEY_ENTER] = true;
-			this->State = GAME_ACTIVE;
-		}
-		if (this->Keys[GLFW_KEY_W] && !this->KeysProcessed[GLFW_KEY_W]) {
-			this->KeysProcessed[GLFW_KEY_W] = true;
-			this->ResetPlayer();
-			this->ResetLevel();
-			Particles->Reset();
-			this->Lives = 3;
-			this->ResetPowerUp();
-			this->Level += 1;
-			this->Level = this->Level % this->Levels.size();
-		}
-		if (this->Keys[GLFW_KEY_S] && !this->KeysProcessed[GLFW_KEY_S]) {
-			this->KeysProcessed[GLFW_KEY_S] = true;
-			this->ResetPlayer();
-			this->ResetLevel();
-			Particles->Reset();
-			this->Lives = 3;
-			this->ResetPowerUp();
-			if(this->Level > 0)
-				this->Level -= 1;
-			else
-				this->Level = this->Levels.size() - 1;
-		}
-	}
-	else if (this->State == GAME_WIN)
-	{
-		if (this->Keys[GLFW_KEY_ENTER])
-		{
-			this->ResetPlayer();
-			this->ResetLevel();
-			this->ResetPowerUp();
-			Particles->Reset();
-			this->KeysProcessed[GLFW_KEY_ENTER] = true;
-			Effects->Chaos = false;
-			this->State = GAME_MENU;
+	if (this->Keys[GLFW_KEY_F1] && !this->KeysProcessed[GLFW_KEY_F1]) {
+		this->KeysProcessed[GLFW_KEY_F1] = true;
+		this->ShowStats = !this->ShowStats;
+	}
+	if (this->Keys[GLFW_KEY_F9] && !this->KeysProcessed[GLFW_KEY_F9]) {
+		this->KeysProcessed[GLFW_KEY_F9] = true;
+		if (Recorder->Recording())
+			Recorder->Stop();
+		else {
+			// one video per recording, named after the time it started
+			char name[64];
+			std::time_t now = std::time(nullptr);
+			std::strftime(name, sizeof(name), "recordings/breakout_%Y%m%d_%H%M%S.y4m", std::localtime(&now));
+			std::error_code error;
+			std::filesystem::create_directories("recordings", error);
+			Recorder->Start(name, this->FramebufferWidth, this->FramebufferHeight);
 		}
 	}
+	for (GameSession* session : this->Sessions)
+		session->ProcessInput(this->Keys, this->KeysProcessed, dt);
 }
 
 void Game::Render() {
-	Effects->BeginRender();
-	// draw background
-	Texture2D background = ResourceManager::GetTexture("background");
-	Renderer->DrawSprite(background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
-	// draw level
-	this->Levels[this->Level].Draw(*Renderer);
-	// draw player
-	Player->Draw(*Renderer);
-	// draw PowerUps
-	for (PowerUp& powerUp : this->PowerUps)
-		if (!powerUp.Destroyed)
-			powerUp.Draw(*Renderer);
-	// draw particles
-	Particles->Draw();
-	// draw ball
-	Ball->Draw(*Renderer);
-	Effects->EndRender();
-	Effects->Render(glfwGetTime());
-	std::stringstream ss;
-	ss << this->Lives;
-	Text->RenderText("Lives:" + ss.str(), 5.0f, 5.0f, 1.0f);
-	switch (this->State) {
-	case GAME_ACTIVE:
-		Text->RenderText("Press m for menu", Width - 250, 5.0f, 1.0f);
-		break;
-	case GAME_MENU:
-		Text->RenderText("Press ENTER to start", 250.0f, Height / 2, 1.0f);
-		Text->RenderText("Press W or S to select level", 245.0f, Height / 2 + 20.0f, 0.75f);
-		break;
-	case GAME_WIN:
-		Text->RenderText("You WON!!!", 260.0, Height / 2 - 40.0, 2.0, glm::vec3(0.0, 1.0, 0.0));
-		Text->RenderText("Press ENTER to retry or ESC to quit", 130.0, Height / 2, 1.0, glm::vec3(1.0, 1.0, 0.0));
-		break;
-	}
-}
-
-void Game::ResetLevel() {
-	// redraw the level
-	for (GameObject& tile : this->Levels[this->Level].Bricks) {
-		tile.Destroyed = false;
-	}
-}
-
-void Game::ResetPlayer() {
-	// reset the ball
-	Ball->Stuck = true;
-	Ball->Position = glm::vec2(this->Width / 2.0f - BALL_RADIUS, this->Height - Player->Size.y - BALL_RADIUS * 2);
-	Ball->Velocity = glm::vec2(100.0f, -350.0f);
-	// reset the player
-	Player->Position = glm::vec2(this->Width / 2.0f - Player->Size.x / 2.0f, this->Height - Player->Size.y);
-	// also disable all active powerups
-	Effects->Chaos = Effects->Confuse = false;
-	Ball->PassThrough = Ball->Sticky = false;
-	Player->Color = glm::vec3(1.0f);
-	Ball->Color = glm::vec3(1.0f);
-}
-
-void ActivatePowerUp(PowerUp& powerUp)
-{
-	if (powerUp.Type == "speed")
-	{
-		Ball->Velocity *= 1.2;
-	}
-	else if (powerUp.Type == "sticky")
-	{
-		Ball->Sticky = true;
-		Player->Color = glm::vec3(1.0f, 0.5f, 1.0f);
-	}
-	else if (powerUp.Type == "pass-through")
-	{
-		Ball->PassThrough = true;
-		Ball->Color = glm::vec3(1.0f, 0.5f, 0.5f);
-	}
-	else if (powerUp.Type == "pad-size-increase")
-	{
-		Player->Size.x += 50;
-	}
-	else if (powerUp.Type == "confuse")
-	{
-		if (!Effects->Chaos)
-			Effects->Confuse = true; // only activate if chaos wasn't already active
-	}
-	else if (powerUp.Type == "chaos")
-	{
-		if (!Effects->Confuse)
-			Effects->Chaos = true;
-	}
-}
-
-// collision detection
-bool CheckCollision(GameObject& one, GameObject& two);
-Collision CheckCollision(BallObject& one, GameObject& two);
-Direction VectorDirection(glm::vec2 closest);
-
-void Game::DoCollisions() {
-	// ball collides with brick
-	for (GameObject& tile : this->Levels[this->Level].Bricks) {
-		if (!tile.Destroyed)
-		{
-			Collision collision = CheckCollision(*Ball, tile);
-			if (!tile.Destroyed) {
-				if (collision.collided) {
-					// destroy block if not solid
-					if (!tile.IsSolid) {
-						tile.Destroyed = true;
-						this->SpawnPowerUps(tile);
-						SoundEngine->play2D("resources/audios/destroy.wav", false);
-					}
-					else
-					{   // if block is solid, enable shake effect
-						ShakeTime = 0.05f;
-						Effects->Shake = true;
-						SoundEngine->play2D("resources/audios/solid.wav", false);
-					}
-					if (!(Ball->PassThrough && !tile.IsSolid)) // don't do collision resolution on non-solid bricks if pass-through is activated
-					{
-						if (collision.direction == LEFT || collision.direction == RIGHT) {
-							// change the ball direction
-							Ball->Velocity.x *= -1;
-							// reposition the ball
-							float penetrationValue = Ball->Radius - std::abs(collision.vector.x);
-							if (collision.direction == LEFT)
-								Ball->Position.x += penetrationValue;
-							else
-								Ball->Position.x -= penetrationValue;
-						}
-						else if (collision.direction == UP || collision.direction == DOWN) {
-							// change the ball direction
-							Ball->Velocity.y *= -1;
-							// reposition the ball
-							float penetrationValue = Ball->Radius - std::abs(collision.vector.y);
-							if (collision.direction == UP)
-								Ball->Position.y -= penetrationValue;
-							else
-								Ball->Position.y += penetrationValue;
-						}
-					}
-				}
-			}
-		}
-	}
-	
-	// ball collides with player
-	Collision collision = CheckCollision(*Ball, *Player);
-	if (!Ball->Stuck && collision.collided) {
-		// reposition the ball
-		float penetrationValue = Ball->Radius - std::abs(collision.vector.y);
-		Ball->Position.y -= penetrationValue;
-		// redirect the ball
-		float playCenter = Player->Position.x + Player->Size.x / 2;
-		float ballCenter = Ball->Position.x + Ball->Radius;
-		// how far the ball from the center of the player
-		float distance = ballCenter - playCenter;
-
-		float percentage = distance / (Player->Size.x / 2.0f);
-		
-		// then move accordingly
-		float strength = 2.0f;
-		glm::vec2 oldVelocity = Ball->Velocity;
-		Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
-		Ball->Velocity.y *= -1;
-		Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
-
-		// if Sticky powerup is activated, also stick ball to paddle once new velocity vectors were calculated
-		Ball->Stuck = Ball->Sticky;
-		SoundEngine->play2D("resources/audios/rebounce.wav", false);
-	}
-
-	for (PowerUp& powerUp : this->PowerUps)
-	{
-		if (!powerUp.Destroyed)
-		{
-			if (powerUp.Position.y >= this->Height)
-				powerUp.Destroyed = true;
-			if (CheckCollision(*Player, powerUp))
-			{	// collided with player, now activate powerup
-				ActivatePowerUp(powerUp);
-				powerUp.Destroyed = true;
-				powerUp.Activated = true;
-				SoundEngine->play2D("resources/audios/powerup.wav", false);
-			}
-		}
-	}
-}
-
-bool CheckCollision(GameObject& one, GameObject& two) // AABB - AABB collision
-{
-	// collision x-axis?
-	bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
-		two.Position.x + two.Size.x >= one.Position.x;
-	// collision y-axis?
-	bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
-		two.Position.y + two.Size.y >= one.Position.y;
-	// collision only if on both axes
-	return collisionX && collisionY;
-}
-
-Collision CheckCollision(BallObject &ball, GameObject &brick) {
-	Collision collision;
-	
-	// get ball's center
-	glm::vec2 ballCenter(ball.Position + ball.Radius);
-	// get brick's center
-	glm::vec2 aabb_half_extents(brick.Size.x / 2.0f, brick.Size.y / 2.0f);
-	glm::vec2 brickCenter(brick.Position + aabb_half_extents);
-
-	// vector pointing from brick's center to ball's center
-	glm::vec2 vector = ballCenter - brickCenter;
-	// closest point to the ball
-	glm::vec2 closestPoint = brickCenter + glm::clamp(vector, -aabb_half_extents, aabb_half_extents);
-	
-	// distance from the closest point to the ball's center
-	float distance = glm::distance(closestPoint, ballCenter);
-
-	collision.collided = distance <= ball.Size.x / 2.0f;
-
-	// calculate collision direction
-	collision.direction = VectorDirection(closestPoint - ballCenter);
-	collision.vector = closestPoint - ballCenter;
-
-	return collision;
-}
-
-Direction VectorDirection(glm::vec2 target){
-	glm::vec2 compass[] = {
-		glm::vec2(0.0f, 1.0f),	// up
-		glm::vec2(1.0f, 0.0f),	// right
-		glm::vec2(0.0f, -1.0f),	// down
-		glm::vec2(-1.0f, 0.0f)	// left
-	};
-
-	float highestValue = 0.0f;
-	int highestIndex = 0;
-
-	for (int i = 0; i < 4; i++) {
-		float newDotProduct = glm::dot(glm::normalize(target), compass[i]);
-		if (newDotProduct > highestValue) {
-			highestValue = newDotProduct;
-			highestIndex = i;
-		}
+	// textures loaded during play are uploaded a slice per frame
+	ResourceManager::UpdateTextures(TEXTURE_UPLOAD_BUDGET);
+	// nothing to render into while the window is minimized
+	if (this->FramebufferWidth == 0 || this->FramebufferHeight == 0)
+		return;
+	StateCache::BeginFrame();
+	Profiler->BeginFrame();
+	GpuProfiler::Scope frameScope(Profiler, "frame");
+	// every session is rendered at the internal resolution and scaled into its viewport
+	unsigned int renderWidth = std::max(static_cast<unsigned int>(std::lround(this->Width * this->RenderScale)), 1u);
+	unsigned int renderHeight = std::max(static_cast<unsigned int>(std::lround(this->Height * this->RenderScale)), 1u);
+	Graph->Reset();
+	FrameGraph::Resource backbuffer = Graph->ImportBackbuffer(this->FramebufferWidth, this->FramebufferHeight);
+	// the sessions' passes follow each other, so their scene targets alias in the graph's pool
+	for (unsigned int i = 0; i < this->Sessions.size(); ++i) {
+		bool fillsBackbuffer = this->FramebufferWidth == renderWidth && this->FramebufferHeight == renderHeight
+			&& this->viewports[i] == glm::ivec4(0, 0, renderWidth, renderHeight);
+		this->Sessions[i]->AddPasses(*Graph, backbuffer, this->viewports[i], renderWidth, renderHeight, fillsBackbuffer, this->Time);
+	}
+	// text is drawn at the framebuffer's resolution, the distance fields keep it sharp at any scale
+	Graph->AddPass("hud", {}, backbuffer, [this](const FrameGraph::PassContext&) { this->RenderHud(); });
+	Graph->Execute();
+	Text->EndFrame();
+	Recorder->Capture(this->Time, this->FramebufferWidth, this->FramebufferHeight);
+}
+
+void Game::Resize(unsigned int width, unsigned int height) {
+	this->FramebufferWidth = width;
+	this->FramebufferHeight = height;
+	// the sessions are laid out in a grid from the top left, each in the largest area with the
+	// game's aspect ratio centered in its cell; the rest stays black
+	unsigned int count = std::clamp(this->SessionCount, 1u, MAX_SESSIONS);
+	unsigned int columns = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<float>(count))));
+	unsigned int rows = (count + columns - 1) / columns;
+	int cellWidth = width / columns, cellHeight = height / rows;
+	float scale = std::min(cellWidth / static_cast<float>(this->Width), cellHeight / static_cast<float>(this->Height));
+	int viewportWidth = static_cast<int>(std::lround(this->Width * scale));
+	int viewportHeight = static_cast<int>(std::lround(this->Height * scale));
+	this->viewports.resize(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		int cellX = (i % columns) * cellWidth;
+		int cellY = static_cast<int>(height) - static_cast<int>(i / columns + 1) * cellHeight;
+		this->viewports[i] = glm::ivec4(cellX + (cellWidth - viewportWidth) / 2, cellY + (cellHeight - viewportHeight) / 2, viewportWidth, viewportHeight);
+	}
+}
+
+void Game::RenderHud() {
+	for (unsigned int i = 0; i < this->Sessions.size(); ++i) {
+		glm::ivec4 viewport = this->viewports[i];
+		glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+		this->Sessions[i]->RenderHud();
+		if (i == 0 && this->ShowStats)
+			this->RenderStats();
+		// draw all text of the session at once
+		Text->Flush();
+	}
+}
+
+void Game::RenderStats() {
+	std::stringstream stats;
+	stats << "GL state calls: " << StateCache::LastFrame.Issued << " issued, " << StateCache::LastFrame.Dropped << " dropped";
+	Text->RenderText(stats.str(), 5.0f, this->Height - 20.0f, 0.5f, glm::vec3(1.0f, 1.0f, 0.0f));
+	// GPU time per pass (a few frames behind), listed above the state calls
+	const std::vector<GpuProfiler::Timing>& timings = Profiler->Timings();
+	float y = this->Height - 20.0f - 15.0f * timings.size();
+	for (const GpuProfiler::Timing& timing : timings) {
+		char line[128];
+		std::snprintf(line, sizeof(line), "%-12s %6.3f ms avg %6.3f p50 %6.3f p95 %6.3f p99", timing.Name, timing.Average, timing.P50, timing.P95, timing.P99);
+		Text->RenderText(line, 5.0f, y, 0.5f, glm::vec3(1.0f, 1.0f, 0.0f));
+		y += 15.0f;
 	}
-
-	return (Direction)highestIndex;
-}
-
-bool ShouldSpawn(unsigned int chance)
-{
-	unsigned int random = rand() % chance;
-	return random == 0;
-}
-void Game::SpawnPowerUps(GameObject& block)
-{
-	if (ShouldSpawn(75)) // 1 in 75 chance
-		this->PowerUps.push_back(
-			PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, block.Position, ResourceManager::GetTexture("powerup_speed")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(
-			PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, block.Position, ResourceManager::GetTexture("powerup_sticky")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(
-			PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, block.Position, ResourceManager::GetTexture("powerup_passthrough")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(
-			PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, block.Position, ResourceManager::GetTexture("powerup_increase")));
-	if (ShouldSpawn(15)) // negative powerups should spawn more often
-		this->PowerUps.push_back(
-			PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, block.Position, ResourceManager::GetTexture("powerup_confuse")));
-	if (ShouldSpawn(15))
-		this->PowerUps.push_back(
-			PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, block.Position, ResourceManager::GetTexture("powerup_chaos")));
-}
-
-bool IsOtherPowerUpActive(std::vector<PowerUp>& powerUps, std::string type)
-{
-	for (const PowerUp& powerUp : powerUps)
-	{
-		if (powerUp.Activated)
-			if (powerUp.Type == type)
-				return true;
-	}
-	return false;
-}
-
-void Game::UpdatePowerUps(float dt)
-{
-	for (PowerUp& powerUp : this->PowerUps)
-	{
-		powerUp.Position += powerUp.Velocity * dt;
-		if (powerUp.Activated)
-		{
-			powerUp.Duration -= dt;
-
-			if (powerUp.Duration <= 0.0f)
-			{
-				// remove powerup from list (will later be removed)
-				powerUp.Activated = false;
-				// deactivate effects
-				if (powerUp.Type == "sticky")
-				{
-					if (!IsOtherPowerUpActive(this->PowerUps, "sticky"))
-					{	// only reset if no other PowerUp of type sticky is active
-						Ball->Sticky = false;
-						Player->Color = glm::vec3(1.0f);
-					}
-				}
-				else if (powerUp.Type == "pass-through")
-				{
-					if (!IsOtherPowerUpActive(this->PowerUps, "pass-through"))
-					{	// only reset if no other PowerUp of type pass-through is active
-						Ball->PassThrough = false;
-						Ball->Color = glm::vec3(1.0f);
-					}
-				}
-				else if (powerUp.Type == "confuse")
-				{
-					if (!IsOtherPowerUpActive(this->PowerUps, "confuse"))
-					{	// only reset if no other PowerUp of type confuse is active
-						Effects->Confuse = false;
-					}
-				}
-				else if (powerUp.Type == "chaos")
-				{
-					if (!IsOtherPowerUpActive(this->PowerUps, "chaos"))
-					{	// only reset if no other PowerUp of type chaos is active
-						Effects->Chaos = false;
-					}
-				}
-			}
-		}
-	}
-	this->PowerUps.erase(std::remove_if(this->PowerUps.begin(), this->PowerUps.end(),
-		[](const PowerUp& powerUp) { return powerUp.Destroyed && !powerUp.Activated; }
-	), this->PowerUps.end());
-}
-
-void Game::ResetPowerUp() {
-	this->PowerUps.clear();
 }
\ No newline at end of file
@@ -14,62 +14,53 @@
 
 #include <vector>
 
-#include "game_level.h"
-#include "ball_object.h"
-#include "power_up.h"
+#include "game_session.h"
 
-// Represents the current state of the game
-enum GameState {
-	GAME_ACTIVE,
-	GAME_MENU,
-	GAME_WIN
-};
-
-enum Direction {
-	UP,     // 0 
-	RIGHT,  // 1
-	DOWN,   // 2
-	LEFT    // 3
-};
-
-struct Collision {
-	bool collided;
-	Direction direction;
-	glm::vec2 vector;
-};
-
-// Game holds all game-related state and funtionality;
-// combines all game-related data into a single class for
-// easy access to each of the components and manageability.
+// Game holds the window-level state and everything shared between the
+// game sessions it shows side by side: the renderers, shaders, textures,
+// fonts and the frame graph are created once and every session draws
+// with them. The keys are shared as well; each session reacts to its own
+// set of them.
 class Game {
 public:
-	unsigned int Lives;
-	std::vector<PowerUp> PowerUps;
-	// game levels
-	std::vector<GameLevel> Levels;
-	unsigned int Level;
-	// game state
-	GameState State;
+	// most sessions shown at once
+	static const unsigned int MAX_SESSIONS = 4;
+	// sessions, laid out from the top left
+	std::vector<GameSession*> Sessions;
 	bool Keys[1024];
 	bool KeysProcessed[1024];
+	// size of a session's screen; the HUD is laid out in these units
 	unsigned int Width, Height;
+	// size of the window's framebuffer in pixels, the sessions are letterboxed into it
+	unsigned int FramebufferWidth, FramebufferHeight;
+	// amount of sessions to create (set before Init), at most MAX_SESSIONS
+	unsigned int SessionCount;
+	// resolution the sessions are rendered at, relative to Width x Height; they're scaled to their viewports afterwards
+	float RenderScale;
+	// debug overlay with render statistics (toggled with F1)
+	bool ShowStats;
+	// game time in seconds, advanced by Update; drives the post-processing effects
+	float Time;
 	// constructor/destructor
 	Game(unsigned int width, unsigned int height);
 	~Game();
 	// initialize game state (load all shaders/textures/levels)
 	void Init();
+	// stops recording and deletes the sessions and renderers; call it while the OpenGL context
+	// is still current, the game is global and destroyed only after the context is gone
+	void Shutdown();
 	// game loop
 	void ProcessInput(float dt);
 	void Update(float dt);
 	void Render();
-	// check collisions
-	void DoCollisions();
-	void SpawnPowerUps(GameObject& block);
-	void UpdatePowerUps(float dt);
+	// adapts rendering to a new framebuffer size
+	void Resize(unsigned int width, unsigned int height);
 private:
-	void ResetLevel();
-	void ResetPlayer();
-	void ResetPowerUp();
+	// area of the framebuffer each session is shown in: <x, y, width, height>
+	std::vector<glm::ivec4> viewports;
+	// render passes
+	void RenderHud();
+	void RenderStats();
 };
 
-#endif // !GAME_H
+#endif // !GAME_H
\ No newline at end of file
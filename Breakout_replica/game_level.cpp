@@ -8,14 +8,67 @@
 ******************************************************************/
 #include "game_level.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <fstream>
 #include <sstream>
+#include <utility>
 
 #include "resource_manager.h"
+#include "state_cache.h"
 
-void GameLevel::Load(const char* file, unsigned int levelWidth, unsigned int levelHeight) {
+// dirty instances at most this far apart are uploaded as one range; another call costs more than re-sending the bricks in between
+const unsigned int DIRTY_RANGE_GAP = 8;
+
+// range of grid cells [first, last] along one axis overlapping [min, max], clamped to the
+// count cells of the grid; returns false if there are none
+static bool cellRange(float min, float max, float cellSize, unsigned int count, int& first, int& last) {
+	if (count == 0)
+		return false;
+	first = std::max(static_cast<int>(std::floor(min / cellSize)), 0);
+	last = std::min(static_cast<int>(std::floor(max / cellSize)), static_cast<int>(count) - 1);
+	return first <= last;
+}
+
+GameLevel::GameLevel(GameLevel&& other) noexcept : GameLevel() {
+	*this = std::move(other);
+}
+
+GameLevel::~GameLevel() {
+	this->release();
+}
+
+GameLevel& GameLevel::operator=(GameLevel&& other) noexcept {
+	if (this == &other)
+		return *this;
+	this->release();
+	this->Bricks = std::move(other.Bricks);
+	this->Size = other.Size;
+	this->columns = other.columns;
+	this->rows = other.rows;
+	this->cell = other.cell;
+	this->grid = std::move(other.grid);
+	this->columnStart = std::move(other.columnStart);
+	this->found = std::move(other.found);
+	this->shader = other.shader;
+	this->materials = other.materials;
+	this->VAO = other.VAO;
+	this->quadVBO = other.quadVBO;
+	this->instanceVBO = other.instanceVBO;
+	this->instanceBase = other.instanceBase;
+	this->instances = std::move(other.instances);
+	this->dirty = std::move(other.dirty);
+	this->changes = std::move(other.changes);
+	// the moved from level no longer owns the objects
+	other.VAO = other.quadVBO = other.instanceVBO = 0;
+	return *this;
+}
+
+void GameLevel::Load(const char* file, unsigned int levelWidth, unsigned int levelHeight, const MaterialLibrary& materials) {
 	// clear old data
 	this->Bricks.clear();
+	this->materials = &materials;
 	// load from file
 	unsigned int tileCode;
 	GameLevel level;
@@ -35,10 +88,70 @@ void GameLevel::Load(const char* file, unsigned int levelWidth, unsigned int lev
 	}
 }
 
-void GameLevel::Draw(SpriteRenderer& renderer) {
-	for (GameObject& tile : this->Bricks)
-		if (!tile.Destroyed)
-			tile.Draw(renderer);
+void GameLevel::Draw(glm::vec2 position, glm::vec2 size) {
+	// upload only the bricks that changed since the last frame, nearby ones together
+	if (!this->dirty.empty()) {
+		std::sort(this->dirty.begin(), this->dirty.end());
+		glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+		for (std::size_t i = 0; i < this->dirty.size(); ) {
+			unsigned int begin = this->dirty[i], end = begin + 1;
+			for (++i; i < this->dirty.size() && this->dirty[i] <= end + DIRTY_RANGE_GAP; ++i)
+				end = this->dirty[i] + 1;
+			for (unsigned int j = begin; j < end; ++j)
+				this->instances[j].Alive = this->Bricks[j].Destroyed ? 0.0f : 1.0f;
+			glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(BrickInstance), (end - begin) * sizeof(BrickInstance), &this->instances[begin]);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		this->dirty.clear();
+	}
+	// only the columns in view; rows aren't culled, levels scroll sideways and the rest is clipped
+	int firstColumn, lastColumn, firstRow, lastRow;
+	if (!cellRange(position.x, position.x + size.x, this->cell.x, this->columns, firstColumn, lastColumn)
+		|| !cellRange(position.y, position.y + size.y, this->cell.y, this->rows, firstRow, lastRow))
+		return;
+	unsigned int first = this->columnStart[firstColumn], count = this->columnStart[lastColumn + 1] - first;
+	if (count == 0)
+		return;
+	// every material is a layer of the same texture, whatever mix of bricks is in view
+	this->shader.Use();
+	StateCache::ActiveTexture(GL_TEXTURE0);
+	this->materials->Bind();
+	StateCache::BindVertexArray(this->VAO);
+	// there's no base instance in OpenGL 3.3, the attributes are moved to the first visible brick instead
+	if (first != this->instanceBase)
+		this->pointInstances(first);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+}
+
+const std::vector<unsigned int>& GameLevel::Query(glm::vec2 position, glm::vec2 size) {
+	this->found.clear();
+	// one cell of slack on each side covers bricks merely touching the area
+	int firstColumn, lastColumn, firstRow, lastRow;
+	if (!cellRange(position.x - this->cell.x, position.x + size.x + this->cell.x, this->cell.x, this->columns, firstColumn, lastColumn)
+		|| !cellRange(position.y - this->cell.y, position.y + size.y + this->cell.y, this->cell.y, this->rows, firstRow, lastRow))
+		return this->found;
+	// row by row like the level file, so bricks are handled in the same order as without the index
+	for (int y = firstRow; y <= lastRow; ++y)
+		for (int x = firstColumn; x <= lastColumn; ++x) {
+			int brick = this->grid[x * this->rows + y];
+			if (brick >= 0)
+				this->found.push_back(brick);
+		}
+	return this->found;
+}
+
+void GameLevel::Destroy(unsigned int index) {
+	this->Bricks[index].Destroyed = true;
+	this->markDirty(index);
+}
+
+void GameLevel::Reset() {
+	for (unsigned int i = 0; i < this->Bricks.size(); ++i) {
+		if (this->Bricks[i].Destroyed) {
+			this->Bricks[i].Destroyed = false;
+			this->markDirty(i);
+		}
+	}
 }
 
 bool GameLevel::IsCompleted() {
@@ -52,36 +165,105 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
 	// calculate dimensions
 	unsigned int height = tileData.size();
 	unsigned int width = tileData[0].size();
-	float unit_width = levelWidth / static_cast<float>(width);
-	float unit_height = levelHeight / height;
-	// initialize level tiles based on tileData
-	for (unsigned int y = 0; y < height; ++y) {
-		for (unsigned int x = 0; x < width; ++x) {
-			// check block type from level data (2D level array)
-			if (tileData[y][x] == 1) { // solid
-				glm::vec2 pos(unit_width * x, unit_height * y);
-				glm::vec2 size(unit_width, unit_height);
-				GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-				obj.IsSolid = true;
-				this->Bricks.push_back(obj);
-			}
-			else if(tileData[y][x] > 1){
-				glm::vec3 color = glm::vec3(1.0f); // original: white
-				if (tileData[y][x] == 2)
-					color = glm::vec3(0.2f, 0.6f, 1.0f);
-				if (tileData[y][x] == 3)
-					color = glm::vec3(0.0f, 0.7f, 0.0f);
-				if (tileData[y][x] == 4)
-					color = glm::vec3(0.8f, 0.8f, 0.4f);
-				if (tileData[y][x] == 5)
-					color = glm::vec3(1.0f, 0.5f, 0.0f);
-
-				glm::vec2 pos(unit_width * x, unit_height * y);
-				glm::vec2 size(unit_width, unit_height);
-				this->Bricks.push_back(
-					GameObject(pos, size, ResourceManager::GetTexture("block"), color)
-				);
+	float unit_width = std::max(levelWidth / static_cast<float>(width), MIN_BRICK_SIZE.x);
+	float unit_height = std::max(static_cast<float>(levelHeight / height), MIN_BRICK_SIZE.y);
+	this->columns = width;
+	this->rows = height;
+	this->cell = glm::vec2(unit_width, unit_height);
+	this->Size = glm::vec2(unit_width * width, unit_height * height);
+	this->grid.assign(width * height, -1);
+	this->columnStart.assign(1, 0);
+	this->instances.clear();
+	// initialize level tiles based on tileData, column by column
+	for (unsigned int x = 0; x < width; ++x) {
+		for (unsigned int y = 0; y < height; ++y) {
+			if (x >= tileData[y].size())
+				continue; // short row
+			if (tileData[y][x] == 0)
+				continue; // empty
+			this->grid[x * height + y] = this->Bricks.size();
+			// the look and solidity of the brick come from the material of its tile code
+			unsigned int material = this->materials->Find(tileData[y][x]);
+			glm::vec2 pos(unit_width * x, unit_height * y);
+			glm::vec2 size(unit_width, unit_height);
+			GameObject obj(pos, size, NO_SPRITE);
+			if (material < this->materials->Materials.size()) {
+				obj.Color = this->materials->Materials[material].Color;
+				obj.IsSolid = this->materials->Materials[material].Solid;
 			}
+			this->Bricks.push_back(obj);
+			BrickInstance instance;
+			instance.Rect = glm::vec4(pos, size);
+			instance.Material = material;
+			instance.Alive = 1.0f;
+			this->instances.push_back(instance);
 		}
+		this->columnStart.push_back(this->Bricks.size());
+	}
+	this->initRenderData();
+}
+
+void GameLevel::initRenderData() {
+	this->shader = ResourceManager::GetShader("brick");
+	this->dirty.clear();
+	if (this->VAO == 0) {
+		// configure VAO with a shared unit quad and a per-instance brick buffer
+		float vertices[] = {
+			// pos      // tex
+			0.0f, 1.0f, 0.0f, 1.0f,
+			1.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 0.0f,
+
+			0.0f, 1.0f, 0.0f, 1.0f,
+			1.0f, 1.0f, 1.0f, 1.0f,
+			1.0f, 0.0f, 1.0f, 0.0f
+		};
+		glGenVertexArrays(1, &this->VAO);
+		glGenBuffers(1, &this->quadVBO);
+		glGenBuffers(1, &this->instanceVBO);
+		StateCache::BindVertexArray(this->VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribDivisor(2, 1);
+		glEnableVertexAttribArray(3);
+		glVertexAttribDivisor(3, 1);
+		this->pointInstances(0);
+		StateCache::BindVertexArray(0);
 	}
+	// upload the whole brick field once per level load
+	glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, this->instances.size() * sizeof(BrickInstance), this->instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GameLevel::pointInstances(unsigned int first) {
+	// expects the VAO to be bound
+	std::size_t base = first * sizeof(BrickInstance);
+	glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)(base + offsetof(BrickInstance, Rect)));
+	glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(BrickInstance), (void*)(base + offsetof(BrickInstance, Material)));
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)(base + offsetof(BrickInstance, Alive)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	this->instanceBase = first;
+}
+
+void GameLevel::markDirty(unsigned int index) {
+	this->changes.push_back(index);
+	this->dirty.push_back(index);
+}
+
+void GameLevel::release() {
+	if (this->VAO == 0)
+		return;
+	glDeleteVertexArrays(1, &this->VAO);
+	glDeleteBuffers(1, &this->quadVBO);
+	glDeleteBuffers(1, &this->instanceVBO);
+	this->VAO = this->quadVBO = this->instanceVBO = 0;
+	// a deleted vertex array was unbound behind the state cache's back
+	StateCache::Invalidate();
 }
\ No newline at end of file
@@ -12,22 +12,92 @@
 #include <vector>
 
 #include "game_object.h"
+#include "material_library.h"
+#include "shader.h"
 
+// Smallest size of a brick; levels with more bricks than fit the area
+// they're loaded into at this size grow beyond it
+const glm::vec2 MIN_BRICK_SIZE(40.0f, 20.0f);
+
+// Per-instance brick data as stored in the level's instance buffer
+struct BrickInstance {
+	glm::vec4    Rect;     // <vec2 position, vec2 size>
+	unsigned int Material; // index into the MaterialLibrary
+	float        Alive;
+};
+
+// GameLevel holds all bricks of a level. The bricks are uploaded once
+// per level load into a GPU instance buffer; destroying or restoring
+// a brick only patches the changed ranges of that buffer on the next
+// Draw() so the whole level renders with a single instanced draw call.
+// The tile codes of the level file are looked up in a MaterialLibrary,
+// so the bricks only differ by their material index.
+// Changed bricks are also recorded for caches of the rendered level.
+//
+// The bricks sit on the tile grid of the level file, which doubles as
+// the level's spatial index: every cell refers to the brick in it. The
+// bricks are stored column by column, so the columns in view are one
+// contiguous range of the instance buffer and are drawn without the rest.
+//
+// A level owns its vertex array and buffers, so it can be moved (e.g.
+// into a vector of levels) but not copied.
 class GameLevel {
 public:
-	// level state
+	// level state, bricks ordered by column
 	std::vector<GameObject> Bricks;
-	// contructor
-	GameLevel(){}
-	// loads level from file
-	void Load(const char* file, unsigned int levelWidth, unsigned int levelHeight);
-	// render level
-	void Draw(SpriteRenderer& renderer);
+	// area covered by the bricks
+	glm::vec2 Size;
+	// contructor/destructor
+	GameLevel() : Size(0.0f), columns(0), rows(0), cell(0.0f), materials(nullptr), VAO(0), quadVBO(0), instanceVBO(0), instanceBase(0) {}
+	GameLevel(GameLevel&& other) noexcept;
+	GameLevel(const GameLevel&) = delete;
+	~GameLevel();
+	GameLevel& operator=(GameLevel&& other) noexcept;
+	GameLevel& operator=(const GameLevel&) = delete;
+	// loads level from file, fitting the bricks into levelWidth x levelHeight unless that
+	// makes them smaller than MIN_BRICK_SIZE; the materials have to outlive the level
+	void Load(const char* file, unsigned int levelWidth, unsigned int levelHeight, const MaterialLibrary& materials);
+	// render the bricks in the columns overlapping the given area
+	void Draw(glm::vec2 position, glm::vec2 size);
+	// indices of the bricks in the cells overlapping the given area (and the cells around it)
+	// in the order of the level file; valid until the next query
+	const std::vector<unsigned int>& Query(glm::vec2 position, glm::vec2 size);
+	// destroys the brick at the given index (marks its instance dirty)
+	void Destroy(unsigned int index);
+	// restores all destroyed bricks
+	void Reset();
 	// check if the level is completed (all non-solid tiles are destroyed
 	bool IsCompleted();
+	// indices of the bricks destroyed or restored since the last call to ClearChanges
+	const std::vector<unsigned int>& Changes() const { return this->changes; }
+	void ClearChanges() { this->changes.clear(); }
 private:
+	// spatial index
+	unsigned int columns, rows;
+	glm::vec2 cell; // size of a grid cell (and of the bricks)
+	std::vector<int> grid; // brick index per cell, column after column, -1 if empty
+	std::vector<unsigned int> columnStart; // index of the first brick of each column, plus the brick count
+	std::vector<unsigned int> found; // result of the last query
+	// render state
+	Shader shader;
+	const MaterialLibrary* materials;
+	unsigned int VAO, quadVBO, instanceVBO;
+	unsigned int instanceBase; // first instance the per-instance attributes point at
+	std::vector<BrickInstance> instances;
+	// instances that still have to be uploaded, in the order they changed (may repeat)
+	std::vector<unsigned int> dirty;
+	// bricks changed since the last ClearChanges
+	std::vector<unsigned int> changes;
 	// initialize level from tile data
 	void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
+	// (re)creates the instance buffer from the instance data
+	void initRenderData();
+	// points the per-instance attributes at the given first instance
+	void pointInstances(unsigned int first);
+	// marks the given brick's instance dirty and records the change
+	void markDirty(unsigned int index);
+	// deletes the vertex array and buffers
+	void release();
 };
 
 #endif // !GAMELEVEL
@@ -9,11 +9,16 @@
 #include "game_object.h"
 
 GameObject::GameObject()
-	: Position(0.0f, 0.0f), Size(1.0f, 1.0f), Velocity(0.0f), Color(1.0f), Rotation(0.0f), Sprite(), IsSolid(false), Destroyed(false){}
+	: Position(0.0f, 0.0f), Size(1.0f, 1.0f), Velocity(0.0f), Color(1.0f), Rotation(0.0f), Sprite(NO_SPRITE), IsSolid(false), Destroyed(false){}
 
-GameObject::GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color, glm::vec2 velocity)
+GameObject::GameObject(glm::vec2 pos, glm::vec2 size, TextureHandle sprite, glm::vec3 color, glm::vec2 velocity)
 	: Position(pos), Size(size), Velocity(velocity), Color(color), Rotation(0.0f), Sprite(sprite), IsSolid(false), Destroyed(false){}
 
 void GameObject::Draw(SpriteRenderer& renderer) {
-	renderer.DrawSprite(this->Sprite, this->Position, this->Size, this->Rotation, this->Color);
+	Texture2D sprite = ResourceManager::GetTexture(this->Sprite);
+	renderer.DrawSprite(sprite, this->Position, this->Size, this->Rotation, this->Color);
+}
+
+void GameObject::Submit(RenderQueue& queue, unsigned int layer, unsigned int depth) {
+	queue.Submit(layer, ResourceManager::GetTexture(this->Sprite), this->Position, this->Size, this->Rotation, this->Color, depth);
 }
\ No newline at end of file
@@ -13,6 +13,11 @@
 
 #include "texture.h"
 #include "sprite_renderer.h"
+#include "render_queue.h"
+#include "resource_manager.h"
+
+// sprite of objects that aren't drawn as sprites (the bricks, drawn instanced by their level)
+const TextureHandle NO_SPRITE = ~0u;
 
 class GameObject {
 public:
@@ -22,13 +27,15 @@ public:
 	float Rotation;
 	bool IsSolid;
 	bool Destroyed;
-	// render state
-	Texture2D Sprite;
+	// render state; a handle, so the object draws whatever texture is stored under it
+	TextureHandle Sprite;
 	// constructor(s)
 	GameObject();
-	GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
+	GameObject(glm::vec2 pos, glm::vec2 size, TextureHandle sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
 	// draw sprite
 	virtual void Draw(SpriteRenderer& renderer);
+	// queues the sprite into a layer of a render queue, in front of the layer's draws with a lower depth
+	virtual void Submit(RenderQueue& queue, unsigned int layer, unsigned int depth = 0);
 };
 
 
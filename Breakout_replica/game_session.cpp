@@ -0,0 +1,676 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "game_session.h"
+#include "resource_manager.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <irrKlang.h>
+
+using namespace irrklang;
+
+// layers of the scene from back to front; draws within one layer must not overlap unless their depths differ
+enum SceneLayer { LAYER_BACKGROUND, LAYER_OBJECTS, LAYER_PARTICLES, LAYER_BALL };
+
+// Initial size of the player paddle
+const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
+// Initial velocity of the player paddle
+const float PLAYER_VELOCITY(500.0f);
+// Initial velocity of the Ball
+const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
+// Radius of the ball object
+const float BALL_RADIUS = 12.5f;
+// Particles a session can keep alive at once
+const unsigned int PARTICLE_CAPACITY = 131072;
+// Particles thrown off by a destroyed brick
+const unsigned int BRICK_BURST = 2000;
+
+struct InitialValue {
+	glm::vec2 playerSize = PLAYER_SIZE;
+	glm::vec2 ballVelocity = INITIAL_BALL_VELOCITY;
+};
+
+struct InitialValue initialValue;
+// <position, size> of the view the shared world shaders currently project
+glm::vec4 ProjectedView;
+
+// names of the render passes of every session; the GPU profiler times passes by name, and keeps the names
+enum RenderPass { PASS_STATIC_LAYER, PASS_SCENE, PASS_POSTPROCESS };
+const char* const PASS_NAMES[][3] = {
+	{ "static layer 1", "scene 1", "postprocess 1" },
+	{ "static layer 2", "scene 2", "postprocess 2" },
+	{ "static layer 3", "scene 3", "postprocess 3" },
+	{ "static layer 4", "scene 4", "postprocess 4" }
+};
+
+GameSession::GameSession(unsigned int index, unsigned int width, unsigned int height, const SessionControls& controls, SpriteRenderer* renderer, RenderQueue* queue, TextRenderer* text, MaterialLibrary* materials, ISoundEngine* soundEngine)
+	: Lives(3), Level(0), State(GAME_MENU), Controls(controls), Index(index), Width(width), Height(height), Renderer(renderer), Queue(queue), Text(text), Materials(materials), SoundEngine(soundEngine),
+	Player(nullptr), Ball(nullptr), Particles(nullptr), Effects(nullptr), Camera(nullptr), Layer(nullptr), layerLevel(0), layerBackground(0), shakeTime(0.0f) {
+}
+
+GameSession::~GameSession() {
+	delete Player;
+	delete Ball;
+	delete Particles;
+	delete Effects;
+	delete Camera;
+	delete Layer;
+}
+
+void GameSession::Init() {
+	Effects = new PostProcessor(this->Width, this->Height);
+	Layer = new StaticLayer(glm::vec2(this->Width, this->Height), this->Width, this->Height, 4);
+	Camera = new Camera2D(glm::vec2(this->Width, this->Height));
+	// look up the shared resources used every frame
+	this->spriteShader = ResourceManager::FindShader("sprite");
+	this->particleShader = ResourceManager::FindShader("particle");
+	this->brickShader = ResourceManager::FindShader("brick");
+	this->spriteProjection = ResourceManager::GetShader(this->spriteShader).GetUniform<glm::mat4>("projection");
+	this->particleProjection = ResourceManager::GetShader(this->particleShader).GetUniform<glm::mat4>("projection");
+	this->brickProjection = ResourceManager::GetShader(this->brickShader).GetUniform<glm::mat4>("projection");
+	this->backgroundTexture = ResourceManager::FindTexture("background");
+	this->speedTexture = ResourceManager::FindTexture("powerup_speed");
+	this->stickyTexture = ResourceManager::FindTexture("powerup_sticky");
+	this->passThroughTexture = ResourceManager::FindTexture("powerup_passthrough");
+	this->increaseTexture = ResourceManager::FindTexture("powerup_increase");
+	this->confuseTexture = ResourceManager::FindTexture("powerup_confuse");
+	this->chaosTexture = ResourceManager::FindTexture("powerup_chaos");
+	// load levels
+	// in name order, the order of the directory listing depends on the file system
+	std::vector<std::filesystem::path> levelFiles;
+	for (const auto& entry : std::filesystem::directory_iterator("levels"))
+		levelFiles.push_back(entry.path());
+	std::sort(levelFiles.begin(), levelFiles.end());
+	for (const auto& file : levelFiles) {
+		GameLevel level; level.Load(file.string().c_str(), this->Width, this->Height / 2, *Materials);
+		this->Levels.push_back(std::move(level));
+	}
+	this->Level = 0;
+	this->layerLevel = this->Level;
+	// load player
+	glm::vec2 world = this->WorldSize();
+	glm::vec2 playerPos = glm::vec2(world.x / 2.0f - PLAYER_SIZE.x / 2.0f, world.y - PLAYER_SIZE.y);
+	Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::FindTexture("paddle"));
+	// load ball 
+	glm::vec2 ballPos = glm::vec2(world.x / 2.0f - BALL_RADIUS, world.y - PLAYER_SIZE.y - BALL_RADIUS * 2);
+	Ball = new BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY, ResourceManager::FindTexture("ball"));
+	Ball->Sticky = false;
+	Ball->PassThrough = false;
+	this->Lives = 3;
+	// initialize particles
+	Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetShader("particle_update"), ResourceManager::FindTexture("particle"), PARTICLE_CAPACITY);
+	// hints name the session's own keys; the font is monospaced at about 15 units per character
+	std::string menuHint = std::string("Press ") + this->Controls.MenuName + " for menu";
+	this->livesLabel.SetStyle(5.0f, 5.0f, 1.0f);
+	this->menuHintLabel.SetText(menuHint);
+	this->menuHintLabel.SetStyle(this->Width - 10.0f - 15.0f * menuHint.size(), 5.0f, 1.0f);
+	this->startLabel.SetText(std::string("Press ") + this->Controls.StartName + " to start");
+	this->startLabel.SetStyle(250.0f, this->Height / 2, 1.0f);
+	this->selectLevelLabel.SetText(std::string("Press ") + this->Controls.LevelNames + " to select level");
+	this->selectLevelLabel.SetStyle(245.0f, this->Height / 2 + 20.0f, 0.75f);
+	this->winLabel.SetText("You WON!!!");
+	this->winLabel.SetStyle(260.0f, this->Height / 2 - 40.0f, 2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+	this->retryLabel.SetText(std::string("Press ") + this->Controls.StartName + " to retry or ESC to quit");
+	this->retryLabel.SetStyle(130.0f, this->Height / 2, 1.0f, glm::vec3(1.0f, 1.0f, 0.0f));
+}
+
+void GameSession::Update(float dt) {
+	glm::vec2 world = this->WorldSize();
+	if (this->State == GAME_ACTIVE) {
+		// update objects
+		Ball->Move(dt, static_cast<unsigned int>(world.x));
+		// check for collisions
+		this->DoCollisions();
+		// ball hit the bottom edge
+		if (Ball->Position.y >= world.y) {
+			SoundEngine->play2D("resources/audios/hurtPlayer.wav", false);
+			--this->Lives;
+			// did the player lose all his lives? : Game over
+			if (this->Lives == 0)
+			{
+				this->Lives = 3;
+				this->ResetLevel();
+				this->State = GAME_MENU;
+				Particles->Reset();
+			}
+			this->ResetPlayer();
+		}
+		// update particle
+		Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2.0f));
+		// update PowerUps
+		this->UpdatePowerUps(dt);
+		if (this->shakeTime > 0.0f)
+		{
+			this->shakeTime -= dt;
+			if (this->shakeTime <= 0.0f)
+				Effects->Shake = false;
+		}
+
+		if (this->Levels[this->Level].IsCompleted())
+		{
+			Effects->Chaos = true;
+			this->State = GAME_WIN;
+			this->Lives = 3;
+			Player->Size = initialValue.playerSize;
+			Player->Velocity = initialValue.ballVelocity;
+		}
+	}
+	// keep the ball and the paddle in view as far as possible
+	glm::vec2 ballCenter = Ball->Position + Ball->Radius, playerCenter = Player->Position + Player->Size / 2.0f;
+	Camera->Follow((ballCenter + playerCenter) / 2.0f, this->WorldSize());
+}
+
+void GameSession::ProcessInput(const bool* keys, bool* keysProcessed, float dt) {
+	// zoom in and out, doubling or halving the zoom per second
+	if (keys[this->Controls.ZoomIn])
+		Camera->SetZoom(Camera->Zoom * std::exp2(dt));
+	if (keys[this->Controls.ZoomOut])
+		Camera->SetZoom(Camera->Zoom * std::exp2(-dt));
+	if (this->State == GAME_ACTIVE) {
+		float velocity = PLAYER_VELOCITY * dt;
+		// move playerboard
+		if (keys[this->Controls.Left]) {
+			if (Player->Position.x > 0.0f) {
+				Player->Position.x -= velocity;
+				if (Ball->Stuck)
+					Ball->Position.x -= velocity;
+			}
+		}
+		if (keys[this->Controls.Right]) {
+			if (Player->Position.x < this->WorldSize().x - Player->Size.x) {
+				Player->Position.x += velocity;
+				if (Ball->Stuck)
+					Ball->Position.x += velocity;
+			}
+		}
+		if (keys[this->Controls.Launch]) {
+			Ball->Stuck = false;
+		}
+		if (keys[this->Controls.Menu]) {
+			this->State = GAME_MENU;
+		}
+	}
+	else if (this->State == GAME_MENU) {
+		SoundEngine->setSoundVolume(0.5f);
+		if (keys[this->Controls.Start] && !keysProcessed[this->Controls.Start]) {
+			keysProcessed[this->Controls.Start] = true;
+			this->State = GAME_ACTIVE;
+		}
+		if (keys[this->Controls.NextLevel] && !keysProcessed[this->Controls.NextLevel]) {
+			keysProcessed[this->Controls.NextLevel] = true;
+			this->ResetLevel();
+			Particles->Reset();
+			this->Lives = 3;
+			this->ResetPowerUp();
+			this->Level += 1;
+			this->Level = this->Level % this->Levels.size();
+			// placed in the new level's world
+			this->ResetPlayer();
+		}
+		if (keys[this->Controls.PreviousLevel] && !keysProcessed[this->Controls.PreviousLevel]) {
+			keysProcessed[this->Controls.PreviousLevel] = true;
+			this->ResetLevel();
+			Particles->Reset();
+			this->Lives = 3;
+			this->ResetPowerUp();
+			if(this->Level > 0)
+				this->Level -= 1;
+			else
+				this->Level = this->Levels.size() - 1;
+			this->ResetPlayer();
+		}
+	}
+	else if (this->State == GAME_WIN)
+	{
+		if (keys[this->Controls.Start])
+		{
+			this->ResetPlayer();
+			this->ResetLevel();
+			this->ResetPowerUp();
+			Particles->Reset();
+			keysProcessed[this->Controls.Start] = true;
+			Effects->Chaos = false;
+			this->State = GAME_MENU;
+		}
+	}
+}
+
+void GameSession::AddPasses(FrameGraph& graph, FrameGraph::Resource backbuffer, glm::ivec4 viewport, unsigned int renderWidth, unsigned int renderHeight, bool fillsBackbuffer, float time) {
+	// the scene is rendered at the internal resolution and scaled into the viewport by the postprocess
+	// pass; if that wouldn't change anything and no effect is active, it's rendered straight into the
+	// (multisampled) backbuffer instead
+	const char* const* passNames = PASS_NAMES[this->Index];
+	FrameGraph::Resource scene = backbuffer;
+	if (!fillsBackbuffer || Effects->EffectsActive())
+		scene = graph.CreateTarget({ renderWidth, renderHeight, 4, GL_RGB });
+	// the background and bricks in view are cached in a layer that's only redrawn where bricks changed;
+	// while the camera scrolls they're drawn straight into the scene, the layer would be redrawn every frame
+	if (Layer->Width != renderWidth || Layer->Height != renderHeight)
+		Layer->Resize(renderWidth, renderHeight);
+	bool scrolling = Layer->SetView(Camera->Position, Camera->Size());
+	GameLevel& level = this->Levels[this->Level];
+	unsigned int background = ResourceManager::GetTexture(this->backgroundTexture).ID;
+	if (this->Level != this->layerLevel || background != this->layerBackground) {
+		Layer->Invalidate();
+		this->layerLevel = this->Level;
+		this->layerBackground = background;
+	}
+	for (unsigned int index : level.Changes())
+		Layer->Invalidate(level.Bricks[index].Position, level.Bricks[index].Size);
+	level.ClearChanges();
+	if (scrolling) {
+		graph.AddPass(passNames[PASS_SCENE], {}, scene, [this](const FrameGraph::PassContext&) {
+			this->project();
+			this->RenderScene(false);
+		});
+	}
+	else {
+		FrameGraph::Resource layer = graph.ImportTarget(Layer->Framebuffer, Layer->Texture, { renderWidth, renderHeight, 1, GL_RGB });
+		if (Layer->Dirty())
+			graph.AddPass(passNames[PASS_STATIC_LAYER], {}, layer, [this](const FrameGraph::PassContext&) {
+				this->project();
+				Layer->Update([this]() { this->RenderStaticLayer(); });
+			});
+		graph.AddPass(passNames[PASS_SCENE], { layer }, scene, [this](const FrameGraph::PassContext&) {
+			this->project();
+			this->RenderScene(true);
+		});
+	}
+	if (scene != backbuffer)
+		graph.AddPass(passNames[PASS_POSTPROCESS], { scene }, backbuffer, [this, scene, viewport, time](const FrameGraph::PassContext& context) {
+			glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+			Effects->Render(context.Texture(scene), time);
+		});
+}
+
+void GameSession::RenderStaticLayer() {
+	// draw background, it stays in place behind the scrolling world
+	Texture2D background = ResourceManager::GetTexture(this->backgroundTexture);
+	Renderer->DrawSprite(background, Camera->Position, Camera->Size(), 0.0f);
+	// draw the level's bricks in view
+	this->Levels[this->Level].Draw(Camera->Position, Camera->Size());
+}
+
+void GameSession::RenderScene(bool useLayer) {
+	// copy the cached background and bricks, or draw them: the background first, it stays in place behind the scrolling world
+	if (useLayer)
+		Layer->Submit(*Queue, LAYER_BACKGROUND);
+	else {
+		Queue->Submit(LAYER_BACKGROUND, ResourceManager::GetTexture(this->backgroundTexture), Camera->Position, Camera->Size());
+		Shader bricks = ResourceManager::GetShader(this->brickShader);
+		Queue->Submit(LAYER_BACKGROUND, RenderQueue::BLEND_ALPHA, bricks.ID, Materials->Texture.ID, [this]() {
+			this->Levels[this->Level].Draw(Camera->Position, Camera->Size());
+		}, 1);
+	}
+	// player and PowerUps in view; a PowerUp is gone as soon as it touches the paddle, but the
+	// PowerUps of nearby bricks overlap each other: later ones are drawn on top
+	if (Camera->Visible(Player->Position, Player->Size))
+		Player->Submit(*Queue, LAYER_OBJECTS);
+	unsigned int depth = 0;
+	for (PowerUp& powerUp : this->PowerUps)
+		if (!powerUp.Destroyed && Camera->Visible(powerUp.Position, powerUp.Size))
+			powerUp.Submit(*Queue, LAYER_OBJECTS, ++depth);
+	// particles glow behind the ball
+	glm::vec4 particles = Particles->Bounds();
+	if (Camera->Visible(glm::vec2(particles.x, particles.y), glm::vec2(particles.z - particles.x, particles.w - particles.y)))
+		Particles->Submit(*Queue, LAYER_PARTICLES);
+	if (Camera->Visible(Ball->Position, Ball->Size))
+		Ball->Submit(*Queue, LAYER_BALL);
+	Queue->Execute();
+}
+
+void GameSession::RenderHud() {
+	// format the lives counter without allocating; the label only lays out again when it changed
+	char lives[32] = "Lives:";
+	std::to_chars_result livesEnd = std::to_chars(lives + 6, lives + sizeof(lives), this->Lives);
+	this->livesLabel.SetText(lives, livesEnd.ptr - lives);
+	Text->Draw(this->livesLabel);
+	switch (this->State) {
+	case GAME_ACTIVE:
+		Text->Draw(this->menuHintLabel);
+		break;
+	case GAME_MENU:
+		Text->Draw(this->startLabel);
+		Text->Draw(this->selectLevelLabel);
+		break;
+	case GAME_WIN:
+		Text->Draw(this->winLabel);
+		Text->Draw(this->retryLabel);
+		break;
+	}
+}
+
+void GameSession::project() {
+	// the world's shaders are shared between the sessions, so their projection only changes along with the view
+	glm::vec4 view(Camera->Position, Camera->Size());
+	if (view == ProjectedView)
+		return;
+	glm::mat4 projection = Camera->Projection();
+	ResourceManager::GetShader(this->spriteShader).Set(this->spriteProjection, projection, true);
+	ResourceManager::GetShader(this->particleShader).Set(this->particleProjection, projection, true);
+	ResourceManager::GetShader(this->brickShader).Set(this->brickProjection, projection, true);
+	ProjectedView = view;
+}
+
+glm::vec2 GameSession::WorldSize() const {
+	// the bricks fill the upper half of the screen, unless the level is larger
+	const GameLevel& level = this->Levels[this->Level];
+	return glm::max(glm::vec2(this->Width, this->Height), glm::vec2(level.Size.x, level.Size.y + this->Height / 2.0f));
+}
+
+void GameSession::ResetLevel() {
+	// redraw the level
+	this->Levels[this->Level].Reset();
+}
+
+void GameSession::ResetPlayer() {
+	// reset the ball
+	Ball->Stuck = true;
+	glm::vec2 world = this->WorldSize();
+	Ball->Position = glm::vec2(world.x / 2.0f - BALL_RADIUS, world.y - Player->Size.y - BALL_RADIUS * 2);
+	Ball->Velocity = glm::vec2(100.0f, -350.0f);
+	// reset the player
+	Player->Position = glm::vec2(world.x / 2.0f - Player->Size.x / 2.0f, world.y - Player->Size.y);
+	// also disable all active powerups
+	Effects->Chaos = Effects->Confuse = false;
+	Ball->PassThrough = Ball->Sticky = false;
+	Player->Color = glm::vec3(1.0f);
+	Ball->Color = glm::vec3(1.0f);
+}
+
+void GameSession::ActivatePowerUp(PowerUp& powerUp)
+{
+	if (powerUp.Type == "speed")
+	{
+		Ball->Velocity *= 1.2;
+	}
+	else if (powerUp.Type == "sticky")
+	{
+		Ball->Sticky = true;
+		Player->Color = glm::vec3(1.0f, 0.5f, 1.0f);
+	}
+	else if (powerUp.Type == "pass-through")
+	{
+		Ball->PassThrough = true;
+		Ball->Color = glm::vec3(1.0f, 0.5f, 0.5f);
+	}
+	else if (powerUp.Type == "pad-size-increase")
+	{
+		Player->Size.x += 50;
+	}
+	else if (powerUp.Type == "confuse")
+	{
+		if (!Effects->Chaos)
+			Effects->Confuse = true; // only activate if chaos wasn't already active
+	}
+	else if (powerUp.Type == "chaos")
+	{
+		if (!Effects->Confuse)
+			Effects->Chaos = true;
+	}
+}
+
+// collision detection
+bool CheckCollision(GameObject& one, GameObject& two);
+Collision CheckCollision(BallObject& one, GameObject& two);
+Direction VectorDirection(glm::vec2 closest);
+
+void GameSession::DoCollisions() {
+	// ball collides with brick
+	// only the bricks around the ball
+	GameLevel& level = this->Levels[this->Level];
+	for (unsigned int i : level.Query(Ball->Position, Ball->Size)) {
+		GameObject& tile = level.Bricks[i];
+		if (!tile.Destroyed)
+		{
+			Collision collision = CheckCollision(*Ball, tile);
+			if (!tile.Destroyed) {
+				if (collision.collided) {
+					// destroy block if not solid
+					if (!tile.IsSolid) {
+						level.Destroy(i);
+						this->SpawnPowerUps(tile);
+						Particles->Burst(tile, BRICK_BURST);
+						SoundEngine->play2D("resources/audios/destroy.wav", false);
+					}
+					else
+					{   // if block is solid, enable shake effect
+						this->shakeTime = 0.05f;
+						Effects->Shake = true;
+						SoundEngine->play2D("resources/audios/solid.wav", false);
+					}
+					if (!(Ball->PassThrough && !tile.IsSolid)) // don't do collision resolution on non-solid bricks if pass-through is activated
+					{
+						if (collision.direction == LEFT || collision.direction == RIGHT) {
+							// change the ball direction
+							Ball->Velocity.x *= -1;
+							// reposition the ball
+							float penetrationValue = Ball->Radius - std::abs(collision.vector.x);
+							if (collision.direction == LEFT)
+								Ball->Position.x += penetrationValue;
+							else
+								Ball->Position.x -= penetrationValue;
+						}
+						else if (collision.direction == UP || collision.direction == DOWN) {
+							// change the ball direction
+							Ball->Velocity.y *= -1;
+							// reposition the ball
+							float penetrationValue = Ball->Radius - std::abs(collision.vector.y);
+							if (collision.direction == UP)
+								Ball->Position.y -= penetrationValue;
+							else
+								Ball->Position.y += penetrationValue;
+						}
+					}
+				}
+			}
+		}
+	}
+	
+	// ball collides with player
+	Collision collision = CheckCollision(*Ball, *Player);
+	if (!Ball->Stuck && collision.collided) {
+		// reposition the ball
+		float penetrationValue = Ball->Radius - std::abs(collision.vector.y);
+		Ball->Position.y -= penetrationValue;
+		// redirect the ball
+		float playCenter = Player->Position.x + Player->Size.x / 2;
+		float ballCenter = Ball->Position.x + Ball->Radius;
+		// how far the ball from the center of the player
+		float distance = ballCenter - playCenter;
+
+		float percentage = distance / (Player->Size.x / 2.0f);
+		
+		// then move accordingly
+		float strength = 2.0f;
+		glm::vec2 oldVelocity = Ball->Velocity;
+		Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
+		Ball->Velocity.y *= -1;
+		Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
+
+		// if Sticky powerup is activated, also stick ball to paddle once new velocity vectors were calculated
+		Ball->Stuck = Ball->Sticky;
+		SoundEngine->play2D("resources/audios/rebounce.wav", false);
+	}
+
+	float bottom = this->WorldSize().y;
+	for (PowerUp& powerUp : this->PowerUps)
+	{
+		if (!powerUp.Destroyed)
+		{
+			if (powerUp.Position.y >= bottom)
+				powerUp.Destroyed = true;
+			if (CheckCollision(*Player, powerUp))
+			{	// collided with player, now activate powerup
+				ActivatePowerUp(powerUp);
+				powerUp.Destroyed = true;
+				powerUp.Activated = true;
+				SoundEngine->play2D("resources/audios/powerup.wav", false);
+			}
+		}
+	}
+}
+
+bool CheckCollision(GameObject& one, GameObject& two) // AABB - AABB collision
+{
+	// collision x-axis?
+	bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
+		two.Position.x + two.Size.x >= one.Position.x;
+	// collision y-axis?
+	bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
+		two.Position.y + two.Size.y >= one.Position.y;
+	// collision only if on both axes
+	return collisionX && collisionY;
+}
+
+Collision CheckCollision(BallObject &ball, GameObject &brick) {
+	Collision collision;
+	
+	// get ball's center
+	glm::vec2 ballCenter(ball.Position + ball.Radius);
+	// get brick's center
+	glm::vec2 aabb_half_extents(brick.Size.x / 2.0f, brick.Size.y / 2.0f);
+	glm::vec2 brickCenter(brick.Position + aabb_half_extents);
+
+	// vector pointing from brick's center to ball's center
+	glm::vec2 vector = ballCenter - brickCenter;
+	// closest point to the ball
+	glm::vec2 closestPoint = brickCenter + glm::clamp(vector, -aabb_half_extents, aabb_half_extents);
+	
+	// distance from the closest point to the ball's center
+	float distance = glm::distance(closestPoint, ballCenter);
+
+	collision.collided = distance <= ball.Size.x / 2.0f;
+
+	// calculate collision direction
+	collision.direction = VectorDirection(closestPoint - ballCenter);
+	collision.vector = closestPoint - ballCenter;
+
+	return collision;
+}
+
+Direction VectorDirection(glm::vec2 target){
+	glm::vec2 compass[] = {
+		glm::vec2(0.0f, 1.0f),	// up
+		glm::vec2(1.0f, 0.0f),	// right
+		glm::vec2(0.0f, -1.0f),	// down
+		glm::vec2(-1.0f, 0.0f)	// left
+	};
+
+	float highestValue = 0.0f;
+	int highestIndex = 0;
+
+	for (int i = 0; i < 4; i++) {
+		float newDotProduct = glm::dot(glm::normalize(target), compass[i]);
+		if (newDotProduct > highestValue) {
+			highestValue = newDotProduct;
+			highestIndex = i;
+		}
+	}
+
+	return (Direction)highestIndex;
+}
+
+bool ShouldSpawn(unsigned int chance)
+{
+	unsigned int random = rand() % chance;
+	return random == 0;
+}
+void GameSession::SpawnPowerUps(GameObject& block)
+{
+	if (ShouldSpawn(75)) // 1 in 75 chance
+		this->PowerUps.push_back(
+			PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, block.Position, this->speedTexture));
+	if (ShouldSpawn(75))
+		this->PowerUps.push_back(
+			PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, block.Position, this->stickyTexture));
+	if (ShouldSpawn(75))
+		this->PowerUps.push_back(
+			PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, block.Position, this->passThroughTexture));
+	if (ShouldSpawn(75))
+		this->PowerUps.push_back(
+			PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, block.Position, this->increaseTexture));
+	if (ShouldSpawn(15)) // negative powerups should spawn more often
+		this->PowerUps.push_back(
+			PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, block.Position, this->confuseTexture));
+	if (ShouldSpawn(15))
+		this->PowerUps.push_back(
+			PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, block.Position, this->chaosTexture));
+}
+
+bool IsOtherPowerUpActive(std::vector<PowerUp>& powerUps, std::string type)
+{
+	for (const PowerUp& powerUp : powerUps)
+	{
+		if (powerUp.Activated)
+			if (powerUp.Type == type)
+				return true;
+	}
+	return false;
+}
+
+void GameSession::UpdatePowerUps(float dt)
+{
+	for (PowerUp& powerUp : this->PowerUps)
+	{
+		powerUp.Position += powerUp.Velocity * dt;
+		if (powerUp.Activated)
+		{
+			powerUp.Duration -= dt;
+
+			if (powerUp.Duration <= 0.0f)
+			{
+				// remove powerup from list (will later be removed)
+				powerUp.Activated = false;
+				// deactivate effects
+				if (powerUp.Type == "sticky")
+				{
+					if (!IsOtherPowerUpActive(this->PowerUps, "sticky"))
+					{	// only reset if no other PowerUp of type sticky is active
+						Ball->Sticky = false;
+						Player->Color = glm::vec3(1.0f);
+					}
+				}
+				else if (powerUp.Type == "pass-through")
+				{
+					if (!IsOtherPowerUpActive(this->PowerUps, "pass-through"))
+					{	// only reset if no other PowerUp of type pass-through is active
+						Ball->PassThrough = false;
+						Ball->Color = glm::vec3(1.0f);
+					}
+				}
+				else if (powerUp.Type == "confuse")
+				{
+					if (!IsOtherPowerUpActive(this->PowerUps, "confuse"))
+					{	// only reset if no other PowerUp of type confuse is active
+						Effects->Confuse = false;
+					}
+				}
+				else if (powerUp.Type == "chaos")
+				{
+					if (!IsOtherPowerUpActive(this->PowerUps, "chaos"))
+					{	// only reset if no other PowerUp of type chaos is active
+						Effects->Chaos = false;
+					}
+				}
+			}
+		}
+	}
+	this->PowerUps.erase(std::remove_if(this->PowerUps.begin(), this->PowerUps.end(),
+		[](const PowerUp& powerUp) { return powerUp.Destroyed && !powerUp.Activated; }
+	), this->PowerUps.end());
+}
+
+void GameSession::ResetPowerUp() {
+	this->PowerUps.clear();
+}
\ No newline at end of file
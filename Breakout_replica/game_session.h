@@ -0,0 +1,139 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GAME_SESSION_H
+#define GAME_SESSION_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "game_level.h"
+#include "ball_object.h"
+#include "power_up.h"
+#include "sprite_renderer.h"
+#include "render_queue.h"
+#include "text_renderer.h"
+#include "particle_generator.h"
+#include "post_processor.h"
+#include "frame_graph.h"
+#include "camera.h"
+#include "static_layer.h"
+#include "resource_manager.h"
+
+namespace irrklang { class ISoundEngine; }
+
+// Represents the current state of the game
+enum GameState {
+	GAME_ACTIVE,
+	GAME_MENU,
+	GAME_WIN
+};
+
+enum Direction {
+	UP,     // 0 
+	RIGHT,  // 1
+	DOWN,   // 2
+	LEFT    // 3
+};
+
+struct Collision {
+	bool collided;
+	Direction direction;
+	glm::vec2 vector;
+};
+
+// The keys a session is played with (GLFW key codes) and how the hints name them
+struct SessionControls {
+	int Left, Right, Launch, Menu, Start, NextLevel, PreviousLevel, ZoomIn, ZoomOut;
+	const char* MenuName;
+	const char* StartName;
+	const char* LevelNames; // both level keys, e.g. "W or S"
+};
+
+// GameSession is one independent game: its levels, paddle, ball,
+// power-ups, particles, effects and camera. Several sessions can be
+// played side by side in one window; they draw with the renderers,
+// shaders, textures and glyph atlas their Game shares between them and
+// each is rendered into the viewport it's given.
+class GameSession {
+public:
+	unsigned int Lives;
+	std::vector<PowerUp> PowerUps;
+	// game levels
+	std::vector<GameLevel> Levels;
+	unsigned int Level;
+	// game state
+	GameState State;
+	SessionControls Controls;
+	// index of the session in its game, from 0 to Game::MAX_SESSIONS - 1
+	unsigned int Index;
+	// size of the session's screen; the camera shows this much of the world at zoom 1 and the HUD is laid out in it
+	unsigned int Width, Height;
+	// renderers, materials and sound engine shared with the other sessions, not owned
+	SpriteRenderer* Renderer;
+	RenderQueue* Queue;
+	TextRenderer* Text;
+	MaterialLibrary* Materials;
+	irrklang::ISoundEngine* SoundEngine;
+	// objects of the session
+	GameObject* Player;
+	BallObject* Ball;
+	ParticleGenerator* Particles;
+	PostProcessor* Effects;
+	Camera2D* Camera;
+	StaticLayer* Layer; // background and bricks, only redrawn where they changed
+	// constructor/destructor
+	GameSession(unsigned int index, unsigned int width, unsigned int height, const SessionControls& controls, SpriteRenderer* renderer, RenderQueue* queue, TextRenderer* text, MaterialLibrary* materials, irrklang::ISoundEngine* soundEngine);
+	~GameSession();
+	// initialize the session's levels and objects; the shared shaders and textures have to be loaded
+	void Init();
+	// game loop
+	void ProcessInput(const bool* keys, bool* keysProcessed, float dt);
+	void Update(float dt);
+	// adds the passes rendering the session into a viewport of the backbuffer; with fillsBackbuffer
+	// (the viewport is all of it, at the render resolution) the scene may be rendered straight into it
+	void AddPasses(FrameGraph& graph, FrameGraph::Resource backbuffer, glm::ivec4 viewport, unsigned int renderWidth, unsigned int renderHeight, bool fillsBackbuffer, float time);
+	// lays out the HUD text into the shared text renderer, the caller flushes it
+	void RenderHud();
+	// size of the current level's world, at least the screen
+	glm::vec2 WorldSize() const;
+	// check collisions
+	void DoCollisions();
+	void SpawnPowerUps(GameObject& block);
+	void UpdatePowerUps(float dt);
+private:
+	unsigned int layerLevel; // level drawn into the layer
+	unsigned int layerBackground; // object of the background texture drawn into the layer
+	float shakeTime;
+	// shared shaders and textures used while playing, resolved once in Init
+	ShaderHandle spriteShader, particleShader, brickShader;
+	Uniform<glm::mat4> spriteProjection, particleProjection, brickProjection;
+	TextureHandle backgroundTexture;
+	TextureHandle speedTexture, stickyTexture, passThroughTexture, increaseTexture, confuseTexture, chaosTexture;
+	// HUD and menu text, laid out once and only again when it changes
+	TextLabel livesLabel;
+	TextLabel menuHintLabel;
+	TextLabel startLabel;
+	TextLabel selectLevelLabel;
+	TextLabel winLabel;
+	TextLabel retryLabel;
+	// render passes
+	void RenderStaticLayer();
+	// draws the scene, with the background and bricks copied from the layer if useLayer is set
+	void RenderScene(bool useLayer);
+	// points the shared shaders' projection at the camera's view
+	void project();
+	void ActivatePowerUp(PowerUp& powerUp);
+	void ResetLevel();
+	void ResetPlayer();
+	void ResetPowerUp();
+};
+
+#endif // !GAME_SESSION_H
\ No newline at end of file
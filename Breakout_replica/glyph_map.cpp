@@ -0,0 +1,101 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "glyph_map.h"
+
+// capacity the map starts out with, must be a power of two
+static const unsigned int INITIAL_CAPACITY = 256;
+
+
+GlyphMap::GlyphMap()
+    : entries(INITIAL_CAPACITY, Entry{ EMPTY, 0 }), count(0)
+{
+}
+
+unsigned int GlyphMap::Find(char32_t codepoint) const
+{
+    unsigned int mask = static_cast<unsigned int>(this->entries.size()) - 1;
+    for (unsigned int i = this->home(codepoint); ; i = (i + 1) & mask)
+    {
+        const Entry& entry = this->entries[i];
+        if (entry.Codepoint == codepoint)
+            return entry.Value;
+        if (entry.Codepoint == EMPTY)
+            return NOT_FOUND;
+    }
+}
+
+void GlyphMap::Insert(char32_t codepoint, unsigned int value)
+{
+    // keep the load factor at or below one half so probe sequences stay short
+    if (2 * (this->count + 1) > this->entries.size())
+        this->grow();
+    unsigned int mask = static_cast<unsigned int>(this->entries.size()) - 1;
+    for (unsigned int i = this->home(codepoint); ; i = (i + 1) & mask)
+    {
+        Entry& entry = this->entries[i];
+        if (entry.Codepoint == EMPTY)
+        {
+            entry.Codepoint = codepoint;
+            ++this->count;
+        }
+        if (entry.Codepoint == codepoint)
+        {
+            entry.Value = value;
+            return;
+        }
+    }
+}
+
+void GlyphMap::Erase(char32_t codepoint)
+{
+    unsigned int mask = static_cast<unsigned int>(this->entries.size()) - 1;
+    unsigned int i = this->home(codepoint);
+    while (this->entries[i].Codepoint != codepoint)
+    {
+        if (this->entries[i].Codepoint == EMPTY)
+            return;
+        i = (i + 1) & mask;
+    }
+    // shift back every following entry whose probe sequence passes the hole
+    for (unsigned int j = (i + 1) & mask; this->entries[j].Codepoint != EMPTY; j = (j + 1) & mask)
+    {
+        unsigned int preferred = this->home(this->entries[j].Codepoint);
+        if (((j - preferred) & mask) >= ((j - i) & mask))
+        {
+            this->entries[i] = this->entries[j];
+            i = j;
+        }
+    }
+    this->entries[i].Codepoint = EMPTY;
+    --this->count;
+}
+
+void GlyphMap::Clear()
+{
+    for (Entry& entry : this->entries)
+        entry.Codepoint = EMPTY;
+    this->count = 0;
+}
+
+unsigned int GlyphMap::home(char32_t codepoint) const
+{
+    // multiplicative (Fibonacci) hashing spreads neighbouring codepoints over the table
+    unsigned int hash = static_cast<unsigned int>(codepoint) * 2654435769u;
+    return (hash ^ (hash >> 16)) & (static_cast<unsigned int>(this->entries.size()) - 1);
+}
+
+void GlyphMap::grow()
+{
+    std::vector<Entry> old(this->entries.size() * 2, Entry{ EMPTY, 0 });
+    old.swap(this->entries);
+    this->count = 0;
+    for (const Entry& entry : old)
+        if (entry.Codepoint != EMPTY)
+            this->Insert(entry.Codepoint, entry.Value);
+}
\ No newline at end of file
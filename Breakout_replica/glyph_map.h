@@ -0,0 +1,49 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GLYPH_MAP_H
+#define GLYPH_MAP_H
+
+#include <vector>
+
+
+// A flat open-addressing hash map from Unicode codepoints to glyph indices.
+// Entries live in one power-of-two sized array and collisions are resolved
+// by linear probing, so a lookup is a hash and (usually) a single cache line.
+// Erasing shifts the following entries back instead of leaving tombstones.
+class GlyphMap
+{
+public:
+    // value returned by Find for codepoints that are not in the map
+    static const unsigned int NOT_FOUND = 0xFFFFFFFF;
+    // constructor
+    GlyphMap();
+    // returns the value stored for a codepoint or NOT_FOUND
+    unsigned int Find(char32_t codepoint) const;
+    // stores a value for a codepoint, replacing any previous value
+    void Insert(char32_t codepoint, unsigned int value);
+    // removes a codepoint from the map (if present)
+    void Erase(char32_t codepoint);
+    // removes all entries
+    void Clear();
+private:
+    struct Entry {
+        char32_t     Codepoint;
+        unsigned int Value;
+    };
+    // key of an unused entry, lies outside of the Unicode range
+    static const char32_t EMPTY = 0xFFFFFFFF;
+    std::vector<Entry> entries;
+    unsigned int       count;
+    // returns the preferred entry of a codepoint
+    unsigned int home(char32_t codepoint) const;
+    // doubles the capacity and reinserts all entries
+    void grow();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+// bound to a reference by std::min, so it needs a definition
+const unsigned int GpuProfiler::WINDOW;
+
+GpuProfiler::GpuProfiler()
+    : current(0)
+{
+    for (Frame& frame : this->frames)
+        frame.Used = 0;
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (Frame& frame : this->frames)
+        if (!frame.Queries.empty())
+            glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+}
+
+void GpuProfiler::BeginFrame()
+{
+    this->current = (this->current + 1) % FRAMES_IN_FLIGHT;
+    this->open.clear();
+    Frame& frame = this->frames[this->current];
+    // this frame's queries were issued FRAMES_IN_FLIGHT frames ago; timestamps complete in order,
+    // so once the last one is available all of them are
+    if (frame.Used > 0)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.Queries[frame.Used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            for (const ScopeRecord& scope : frame.Scopes)
+            {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(frame.Queries[scope.BeginQuery], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(frame.Queries[scope.EndQuery], GL_QUERY_RESULT, &end);
+                this->record(scope.Name, static_cast<float>(end - begin) / 1000000.0f); // nanoseconds to milliseconds
+            }
+        }
+    }
+    frame.Used = 0;
+    frame.Scopes.clear();
+}
+
+void GpuProfiler::Begin(const char* name)
+{
+    Frame& frame = this->frames[this->current];
+    this->open.push_back(static_cast<unsigned int>(frame.Scopes.size()));
+    frame.Scopes.push_back({ name, this->timestamp(), 0 });
+}
+
+void GpuProfiler::End()
+{
+    if (this->open.empty())
+        return;
+    Frame& frame = this->frames[this->current];
+    frame.Scopes[this->open.back()].EndQuery = this->timestamp();
+    this->open.pop_back();
+}
+
+const std::vector<GpuProfiler::Timing>& GpuProfiler::Timings()
+{
+    this->timings.clear();
+    for (const Samples& scope : this->samples)
+    {
+        if (scope.Count == 0)
+            continue;
+        this->sorted.assign(scope.Values, scope.Values + scope.Count);
+        std::sort(this->sorted.begin(), this->sorted.end());
+        float sum = 0.0f;
+        for (float value : this->sorted)
+            sum += value;
+        unsigned int last = scope.Count - 1;
+        this->timings.push_back({
+            scope.Name,
+            sum / scope.Count,
+            this->sorted[last * 50 / 100],
+            this->sorted[last * 95 / 100],
+            this->sorted[last * 99 / 100]
+        });
+    }
+    return this->timings;
+}
+
+unsigned int GpuProfiler::timestamp()
+{
+    Frame& frame = this->frames[this->current];
+    if (frame.Used == frame.Queries.size())
+    {
+        unsigned int query;
+        glGenQueries(1, &query);
+        frame.Queries.push_back(query);
+    }
+    glQueryCounter(frame.Queries[frame.Used], GL_TIMESTAMP);
+    return frame.Used++;
+}
+
+void GpuProfiler::record(const char* name, float milliseconds)
+{
+    // there are only a handful of scopes, a linear search is all it takes
+    Samples* scope = nullptr;
+    for (Samples& candidate : this->samples)
+        if (candidate.Name == name || std::strcmp(candidate.Name, name) == 0)
+            scope = &candidate;
+    if (!scope)
+    {
+        this->samples.push_back(Samples());
+        scope = &this->samples.back();
+        scope->Name = name;
+        scope->Count = scope->Next = 0;
+    }
+    scope->Values[scope->Next] = milliseconds;
+    scope->Next = (scope->Next + 1) % WINDOW;
+    scope->Count = std::min(scope->Count + 1, WINDOW);
+}
+
+
+GpuProfiler::Scope::Scope(GpuProfiler* profiler, const char* name)
+    : profiler(profiler)
+{
+    if (this->profiler)
+        this->profiler->Begin(name);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    if (this->profiler)
+        this->profiler->End();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// GpuProfiler measures how long the GPU spends in named scopes of a
+// frame using GL_TIMESTAMP queries (timestamps rather than
+// GL_TIME_ELAPSED, so scopes may nest). The queries of the last
+// FRAMES_IN_FLIGHT frames are kept apart and a frame's results are only
+// read once it comes around again, when the GPU has long finished it;
+// results that still aren't available are skipped rather than waited
+// for. Every scope keeps a rolling window of its timings from which the
+// average and percentiles are computed.
+class GpuProfiler
+{
+public:
+    // timing statistics of a scope in milliseconds
+    struct Timing {
+        const char* Name;
+        float       Average, P50, P95, P99;
+    };
+    // frames whose queries may be in flight at once
+    static const unsigned int FRAMES_IN_FLIGHT = 3;
+    // samples the rolling statistics are computed from
+    static const unsigned int WINDOW = 120;
+    // constructor/destructor
+    GpuProfiler();
+    ~GpuProfiler();
+    // collects the results of an earlier frame and starts recording a new one
+    void BeginFrame();
+    // opens a named scope; name must stay valid for the profiler's life (e.g. a string literal)
+    void Begin(const char* name);
+    // closes the most recently opened scope
+    void End();
+    // returns the statistics of every scope measured so far
+    const std::vector<Timing>& Timings();
+    // opens a scope for its lifetime
+    class Scope
+    {
+    public:
+        Scope(GpuProfiler* profiler, const char* name);
+        ~Scope();
+    private:
+        GpuProfiler* profiler;
+    };
+private:
+    struct ScopeRecord {
+        const char*  Name;
+        unsigned int BeginQuery, EndQuery; // indices into the frame's queries
+    };
+    struct Frame {
+        std::vector<unsigned int> Queries;
+        unsigned int              Used; // queries issued this frame
+        std::vector<ScopeRecord>  Scopes;
+    };
+    struct Samples {
+        const char*  Name;
+        float        Values[WINDOW];
+        unsigned int Count, Next;
+    };
+    Frame                     frames[FRAMES_IN_FLIGHT];
+    unsigned int              current;
+    std::vector<unsigned int> open;    // scopes opened and not yet closed
+    std::vector<Samples>      samples;
+    std::vector<Timing>       timings;
+    std::vector<float>        sorted;  // scratch storage for the percentiles
+    // issues a timestamp query and returns its index in the current frame
+    unsigned int timestamp();
+    // adds a measured duration to a scope's rolling window
+    void record(const char* name, float milliseconds);
+};
+
+#endif
\ No newline at end of file
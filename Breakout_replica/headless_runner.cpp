@@ -0,0 +1,284 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "headless_runner.h"
+#include "game.h"
+#include "state_cache.h"
+#include "png_writer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "stb_image.h"
+
+// fixed simulation step
+const float TIME_STEP = 1.0f / 60.0f;
+// longest wait for a fence before giving up on it (in nanoseconds)
+const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+
+HeadlessRunner::HeadlessRunner(Game& game, unsigned int width, unsigned int height)
+    : game(game), width(width), height(height), frames(0), tolerance(0), maxDifferent(0.0f), nextReadback(0), updateGolden(false), failures(0)
+{
+    for (Readback& readback : this->readbacks)
+    {
+        glGenBuffers(1, &readback.PBO);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 3, NULL, GL_STREAM_READ);
+        readback.Fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->pixels.resize(width * height * 3);
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    for (Readback& readback : this->readbacks)
+    {
+        if (readback.Fence)
+            glDeleteSync(readback.Fence);
+        glDeleteBuffers(1, &readback.PBO);
+    }
+}
+
+bool HeadlessRunner::Load(const char* file)
+{
+    std::ifstream fstream(file);
+    if (!fstream)
+    {
+        std::cout << "ERROR::HEADLESS: Failed to read script " << file << std::endl;
+        return false;
+    }
+    this->events.clear();
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(fstream, line))
+    {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream sstream(line);
+        std::string word;
+        if (!(sstream >> word))
+            continue;
+        bool valid = true;
+        if (word == "frames")
+            valid = static_cast<bool>(sstream >> this->frames);
+        else if (word == "tolerance")
+            valid = static_cast<bool>(sstream >> this->tolerance >> this->maxDifferent);
+        else
+        {
+            Event event;
+            std::string type, argument;
+            event.Frame = std::strtoul(word.c_str(), nullptr, 10);
+            event.Key = -1;
+            valid = static_cast<bool>(sstream >> type >> argument);
+            if (type == "press" || type == "release")
+            {
+                event.Type = type == "press" ? EVENT_PRESS : EVENT_RELEASE;
+                event.Key = keyCode(argument);
+                valid = valid && event.Key >= 0;
+            }
+            else if (type == "capture")
+            {
+                event.Type = EVENT_CAPTURE;
+                event.Name = argument;
+            }
+            else
+                valid = false;
+            if (valid)
+                this->events.push_back(event);
+        }
+        if (!valid)
+        {
+            std::cout << "ERROR::HEADLESS: Invalid command in " << file << " line " << lineNumber << std::endl;
+            return false;
+        }
+    }
+    std::stable_sort(this->events.begin(), this->events.end(), [](const Event& a, const Event& b) { return a.Frame < b.Frame; });
+    return true;
+}
+
+unsigned int HeadlessRunner::Run(const std::string& goldenDir, bool updateGolden)
+{
+    typedef std::chrono::steady_clock Clock;
+    this->goldenDir = goldenDir;
+    this->updateGolden = updateGolden;
+    this->failures = 0;
+    std::vector<float> frameTimes;
+    frameTimes.reserve(this->frames);
+    GLsync inFlight[FRAMES_IN_FLIGHT] = {};
+    std::vector<Event>::const_iterator event = this->events.begin();
+    Clock::time_point previous = Clock::now();
+    for (unsigned int frame = 0; frame < this->frames; ++frame)
+    {
+        // like swapping buffers, don't start a frame before the GPU is done with the one FRAMES_IN_FLIGHT frames ago
+        GLsync& fence = inFlight[frame % FRAMES_IN_FLIGHT];
+        if (fence)
+        {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+            glDeleteSync(fence);
+        }
+        // scripted input, handled the way the key callback does
+        std::vector<Event>::const_iterator frameEnd = event;
+        for (; frameEnd != this->events.end() && frameEnd->Frame <= frame; ++frameEnd)
+        {
+            if (frameEnd->Type == EVENT_PRESS)
+                this->game.Keys[frameEnd->Key] = true;
+            else if (frameEnd->Type == EVENT_RELEASE)
+            {
+                this->game.Keys[frameEnd->Key] = false;
+                this->game.KeysProcessed[frameEnd->Key] = false;
+            }
+        }
+        this->game.ProcessInput(TIME_STEP);
+        this->game.Update(TIME_STEP);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        this->game.Render();
+        for (; event != frameEnd; ++event)
+            if (event->Type == EVENT_CAPTURE)
+                this->capture(event->Name);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        this->collect(false);
+
+        Clock::time_point now = Clock::now();
+        frameTimes.push_back(std::chrono::duration<float, std::milli>(now - previous).count());
+        previous = now;
+    }
+    this->collect(true);
+    for (GLsync fence : inFlight)
+        if (fence)
+            glDeleteSync(fence);
+
+    // frame time statistics
+    if (!frameTimes.empty())
+    {
+        float sum = 0.0f;
+        for (float time : frameTimes)
+            sum += time;
+        std::sort(frameTimes.begin(), frameTimes.end());
+        std::size_t last = frameTimes.size() - 1;
+        std::printf("%u frames in %.1f ms: avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            this->frames, sum, sum / frameTimes.size(), frameTimes[last * 50 / 100], frameTimes[last * 95 / 100], frameTimes[last * 99 / 100], frameTimes[last]);
+    }
+    return this->failures;
+}
+
+void HeadlessRunner::capture(const std::string& name)
+{
+    // all PBOs in flight: the oldest capture has to be finished first
+    Readback& readback = this->readbacks[this->nextReadback];
+    if (readback.Fence)
+    {
+        glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        this->check(readback);
+    }
+    this->nextReadback = (this->nextReadback + 1) % READBACK_COUNT;
+    // copy the (resolved) default framebuffer into the PBO, glReadPixels returns right away
+    StateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->width, this->height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.Name = name;
+}
+
+void HeadlessRunner::collect(bool wait)
+{
+    // oldest capture first, so results are reported in order
+    for (unsigned int i = 0; i < READBACK_COUNT; ++i)
+    {
+        Readback& readback = this->readbacks[(this->nextReadback + i) % READBACK_COUNT];
+        if (!readback.Fence)
+            continue;
+        GLenum status = glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FENCE_TIMEOUT : 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return;
+        this->check(readback);
+    }
+}
+
+void HeadlessRunner::check(Readback& readback)
+{
+    glDeleteSync(readback.Fence);
+    readback.Fence = nullptr;
+    // OpenGL's rows start at the bottom, PNG's at the top
+    std::size_t stride = this->width * 3;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+    const unsigned char* data = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, stride * this->height, GL_MAP_READ_BIT));
+    if (data)
+    {
+        for (unsigned int y = 0; y < this->height; ++y)
+            std::copy(data + y * stride, data + (y + 1) * stride, this->pixels.begin() + (this->height - 1 - y) * stride);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::string golden = this->goldenDir + "/" + readback.Name + ".png";
+    if (this->updateGolden)
+    {
+        if (WritePng(golden.c_str(), this->width, this->height, this->pixels.data()))
+            std::printf("%-24s updated %s\n", readback.Name.c_str(), golden.c_str());
+        else
+        {
+            std::printf("%-24s FAILED to write %s\n", readback.Name.c_str(), golden.c_str());
+            ++this->failures;
+        }
+        return;
+    }
+    int goldenWidth, goldenHeight, channels;
+    unsigned char* expected = stbi_load(golden.c_str(), &goldenWidth, &goldenHeight, &channels, 3);
+    bool matches = false;
+    if (!expected)
+        std::printf("%-24s FAILED, no golden image %s\n", readback.Name.c_str(), golden.c_str());
+    else if (goldenWidth != static_cast<int>(this->width) || goldenHeight != static_cast<int>(this->height))
+        std::printf("%-24s FAILED, golden image is %dx%d\n", readback.Name.c_str(), goldenWidth, goldenHeight);
+    else
+    {
+        unsigned int pixelCount = this->width * this->height, different = 0;
+        for (unsigned int i = 0; i < pixelCount; ++i)
+            for (unsigned int c = 0; c < 3; ++c)
+                if (std::abs(this->pixels[i * 3 + c] - expected[i * 3 + c]) > this->tolerance)
+                {
+                    ++different;
+                    break;
+                }
+        matches = different <= this->maxDifferent * pixelCount;
+        std::printf("%-24s %s, %u of %u pixels differ\n", readback.Name.c_str(), matches ? "ok" : "FAILED", different, pixelCount);
+    }
+    stbi_image_free(expected);
+    // keep what was rendered next to the golden image to look into the failure
+    if (!matches)
+    {
+        ++this->failures;
+        WritePng((this->goldenDir + "/" + readback.Name + ".actual.png").c_str(), this->width, this->height, this->pixels.data());
+    }
+}
+
+int HeadlessRunner::keyCode(const std::string& name)
+{
+    if (name.size() == 1 && std::isalnum(static_cast<unsigned char>(name[0])))
+        return std::toupper(static_cast<unsigned char>(name[0])); // GLFW's letter and digit keys are their ASCII codes
+    if (name == "SPACE")
+        return GLFW_KEY_SPACE;
+    if (name == "ENTER")
+        return GLFW_KEY_ENTER;
+    if (name == "F1")
+        return GLFW_KEY_F1;
+    if (name == "F9")
+        return GLFW_KEY_F9;
+    return -1;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+class Game;
+
+
+// HeadlessRunner plays a Game through a script of simulated frames at a
+// fixed 60 Hz time step, without a window: scripted key presses drive the
+// game and scripted captures read the rendered frame back and compare it
+// with a golden PNG. Captures are copied into pixel buffer objects and
+// only read once their fence has passed, so they don't stall the frames
+// being timed. At the end the frame time statistics are printed.
+//
+// Script lines, '#' starts a comment:
+//   frames <count>                  amount of frames to run
+//   tolerance <channel> <fraction>  a capture fails if more than fraction of its pixels
+//                                   differ by more than channel in any color channel
+//   <frame> press|release <key>     key name: a letter, a digit, SPACE, ENTER, F1 or F9
+//   <frame> capture <name>          compares the frame with <golden dir>/<name>.png
+class HeadlessRunner
+{
+public:
+    // constructor/destructor, requires a current OpenGL context
+    HeadlessRunner(Game& game, unsigned int width, unsigned int height);
+    ~HeadlessRunner();
+    // loads a script; returns false if it can't be read
+    bool Load(const char* file);
+    // runs the loaded script; with updateGolden the captures replace their golden images
+    // instead of being compared. Returns the amount of captures that didn't match
+    unsigned int Run(const std::string& goldenDir, bool updateGolden);
+private:
+    enum EventType { EVENT_PRESS, EVENT_RELEASE, EVENT_CAPTURE };
+    struct Event {
+        unsigned int Frame;
+        EventType    Type;
+        int          Key;  // GLFW key code of press/release events
+        std::string  Name; // capture name
+    };
+    struct Readback {
+        unsigned int PBO;
+        GLsync       Fence; // passed once the copy into the PBO is done (nullptr if unused)
+        std::string  Name;
+    };
+    // captures that may be in flight at once
+    static const unsigned int READBACK_COUNT = 3;
+    // frames the CPU may run ahead of the GPU, as a swap chain would allow
+    static const unsigned int FRAMES_IN_FLIGHT = 2;
+    Game&              game;
+    unsigned int       width, height;
+    // script
+    std::vector<Event> events; // ordered by frame
+    unsigned int       frames;
+    int                tolerance;
+    float              maxDifferent;
+    // captures
+    Readback                   readbacks[READBACK_COUNT];
+    unsigned int               nextReadback;
+    std::vector<unsigned char> pixels; // top-down RGB image of the capture being checked
+    std::string                goldenDir;
+    bool                       updateGolden;
+    unsigned int               failures;
+    // starts reading the current frame back into a free PBO
+    void capture(const std::string& name);
+    // checks the captures whose copies are done; with wait it waits for all of them
+    void collect(bool wait);
+    // compares a finished capture with its golden image (or replaces it)
+    void check(Readback& readback);
+    // returns the GLFW key code of a script key name, -1 if unknown
+    static int keyCode(const std::string& name);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "ktx_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const std::uint32_t KTX_ENDIANNESS = 0x04030201;
+
+// the header following the identifier, in the byte order of the machine that wrote it
+struct KtxHeader {
+    std::uint32_t Endianness;
+    std::uint32_t GlType, GlTypeSize, GlFormat, GlInternalFormat, GlBaseInternalFormat;
+    std::uint32_t PixelWidth, PixelHeight, PixelDepth;
+    std::uint32_t NumberOfArrayElements, NumberOfFaces, NumberOfMipmapLevels;
+    std::uint32_t BytesOfKeyValueData;
+};
+
+// a block compressed format the loader accepts, every format uses 4x4 pixel blocks
+struct BlockFormat {
+    std::uint32_t InternalFormat;
+    unsigned int  BlockSize;  // bytes per block
+    const char*   Extension; // extension the context needs to sample it, nullptr if core
+};
+
+static const BlockFormat BLOCK_FORMATS[] = {
+    { GL_COMPRESSED_RGB_S3TC_DXT1_EXT,  8,  "GL_EXT_texture_compression_s3tc" },
+    { 0x83F1 /* RGBA DXT1 */,           8,  "GL_EXT_texture_compression_s3tc" },
+    { 0x83F2 /* RGBA DXT3 */,           16, "GL_EXT_texture_compression_s3tc" },
+    { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16, "GL_EXT_texture_compression_s3tc" },
+    { GL_COMPRESSED_RED_RGTC1,          8,  nullptr },
+    { GL_COMPRESSED_RG_RGTC2,           16, nullptr },
+    { 0x8E8C /* RGBA BPTC (BC7) */,     16, "GL_ARB_texture_compression_bptc" },
+    { 0x9274 /* RGB8 ETC2 */,           8,  "GL_ARB_ES3_compatibility" },
+    { 0x9278 /* RGBA8 ETC2 EAC */,      16, "GL_ARB_ES3_compatibility" },
+};
+
+// returns true if the current context supports an extension
+static bool extensionSupported(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+        if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+            return true;
+    return false;
+}
+
+// returns the block format of an internal format, nullptr if it isn't one the loader accepts
+static const BlockFormat* findFormat(std::uint32_t internalFormat)
+{
+    for (const BlockFormat& format : BLOCK_FORMATS)
+        if (format.InternalFormat == internalFormat)
+            return &format;
+    return nullptr;
+}
+
+// size in bytes of a mipmap level of a block compressed texture
+static std::uint32_t levelSize(const BlockFormat& format, unsigned int width, unsigned int height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * format.BlockSize;
+}
+
+
+bool ReadKtx(const char* file, KtxImage& image)
+{
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+        return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    KtxHeader header;
+    if (data.size() < sizeof(KTX_IDENTIFIER) + sizeof(header) || std::memcmp(data.data(), KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+    {
+        std::cout << "ERROR::KTX: Not a KTX 1.1 file: " << file << std::endl;
+        return false;
+    }
+    std::memcpy(&header, data.data() + sizeof(KTX_IDENTIFIER), sizeof(header));
+    // the files are written by the converter on the same (little endian) platforms the game runs on
+    if (header.Endianness != KTX_ENDIANNESS)
+    {
+        std::cout << "ERROR::KTX: Byte order not supported: " << file << std::endl;
+        return false;
+    }
+    const BlockFormat* format = findFormat(header.GlInternalFormat);
+    if (header.GlType != 0 || !format || header.PixelDepth > 1 || header.NumberOfArrayElements > 0 || header.NumberOfFaces != 1)
+    {
+        std::cout << "ERROR::KTX: Only block compressed 2D textures are supported: " << file << std::endl;
+        return false;
+    }
+    // a level count of 0 asks the loader to generate the mipmaps, compressed data can't have them generated
+    unsigned int levels = std::max(header.NumberOfMipmapLevels, 1u);
+    image.InternalFormat = header.GlInternalFormat;
+    image.BaseFormat = header.GlBaseInternalFormat;
+    image.Width = header.PixelWidth;
+    image.Height = header.PixelHeight;
+    image.Levels.resize(levels);
+    std::size_t offset = sizeof(KTX_IDENTIFIER) + sizeof(header) + header.BytesOfKeyValueData;
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        std::uint32_t size = 0;
+        if (offset + sizeof(size) <= data.size())
+            std::memcpy(&size, data.data() + offset, sizeof(size));
+        offset += sizeof(size);
+        if (size != levelSize(*format, std::max(header.PixelWidth >> level, 1u), std::max(header.PixelHeight >> level, 1u)) || offset + size > data.size())
+        {
+            std::cout << "ERROR::KTX: Mipmap level " << level << " is truncated: " << file << std::endl;
+            return false;
+        }
+        image.Levels[level].assign(data.begin() + offset, data.begin() + offset + size);
+        // levels are padded to a multiple of 4 bytes
+        offset += (size + 3) & ~3u;
+    }
+    return true;
+}
+
+bool CompressedFormatSupported(unsigned int format)
+{
+    const BlockFormat* block = findFormat(format);
+    return block && (!block->Extension || extensionSupported(block->Extension));
+}
+
+bool LoadKtx(const char* file, Texture2D& texture)
+{
+    KtxImage image;
+    if (!ReadKtx(file, image))
+        return false;
+    if (!CompressedFormatSupported(image.InternalFormat))
+        return false; // not an error, the caller falls back to the uncompressed image
+    unsigned int levels = static_cast<unsigned int>(image.Levels.size());
+    std::vector<const unsigned char*> data(levels);
+    std::vector<unsigned int> sizes(levels);
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        data[level] = image.Levels[level].data();
+        sizes[level] = static_cast<unsigned int>(image.Levels[level].size());
+    }
+    texture.Internal_Format = image.InternalFormat;
+    texture.Image_Format = image.BaseFormat;
+    if (levels > 1 && texture.Filter_Min == GL_LINEAR)
+        texture.Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+    texture.GenerateCompressed(image.Width, image.Height, levels, data.data(), sizes.data());
+    return true;
+}
+
+bool WriteKtx(const char* file, unsigned int internalFormat, unsigned int baseFormat, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels)
+{
+    // a single key/value pair: its size, the null terminated key and value, padded to 4 bytes
+    static const char orientation[] = "KTXorientation\0S=r,T=d";
+    std::uint32_t pairSize = sizeof(orientation);
+    std::uint32_t pairPadding = (4 - pairSize % 4) % 4;
+    KtxHeader header = {};
+    header.Endianness = KTX_ENDIANNESS;
+    header.GlTypeSize = 1;
+    header.GlInternalFormat = internalFormat;
+    header.GlBaseInternalFormat = baseFormat;
+    header.PixelWidth = width;
+    header.PixelHeight = height;
+    header.NumberOfFaces = 1;
+    header.NumberOfMipmapLevels = static_cast<std::uint32_t>(levels.size());
+    header.BytesOfKeyValueData = sizeof(pairSize) + pairSize + pairPadding;
+
+    std::ofstream stream(file, std::ios::binary);
+    if (!stream)
+        return false;
+    static const char padding[4] = {};
+    stream.write(reinterpret_cast<const char*>(KTX_IDENTIFIER), sizeof(KTX_IDENTIFIER));
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&pairSize), sizeof(pairSize));
+    stream.write(orientation, pairSize);
+    stream.write(padding, pairPadding);
+    for (const std::vector<unsigned char>& level : levels)
+    {
+        std::uint32_t size = static_cast<std::uint32_t>(level.size());
+        stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        stream.write(reinterpret_cast<const char*>(level.data()), size);
+        stream.write(padding, (4 - size % 4) % 4);
+    }
+    return static_cast<bool>(stream);
+}
\ No newline at end of file
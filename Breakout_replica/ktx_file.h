@@ -0,0 +1,49 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include <vector>
+
+#include "texture.h"
+
+// block compressed formats of extensions the core profile headers don't define
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+
+// Reads and writes KTX 1.1 files holding a block compressed (BCn or ETC2)
+// texture together with its mipmap levels, so loading one is a straight
+// copy into video memory without decoding or generating mipmaps. The rows
+// are stored from top to bottom, the order stb_image loads images in, so a
+// converted texture samples exactly like its source image (the files say
+// so with the "KTXorientation" key "S=r,T=d").
+
+// contents of a KTX file: the format, size and the block compressed mipmap levels, largest first
+struct KtxImage {
+    unsigned int                            InternalFormat, BaseFormat;
+    unsigned int                            Width, Height;
+    std::vector<std::vector<unsigned char>> Levels;
+};
+
+// reads a block compressed 2D texture from a KTX file; returns false if the file doesn't exist or isn't one
+bool ReadKtx(const char* file, KtxImage& image);
+// returns true if the current context can sample a block compressed format
+bool CompressedFormatSupported(unsigned int format);
+// loads a KTX file into texture, sampling it trilinearly if it has mipmaps. Returns false if the file
+// doesn't exist, isn't a compressed KTX 1.1 file or its format isn't supported by the current context
+bool LoadKtx(const char* file, Texture2D& texture);
+// writes the block compressed mipmap levels of a texture, largest first, to a KTX 1.1 file; returns false if it can't be written
+bool WriteKtx(const char* file, unsigned int internalFormat, unsigned int baseFormat, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels);
+
+#endif
\ No newline at end of file
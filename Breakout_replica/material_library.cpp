@@ -0,0 +1,186 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "material_library.h"
+#include "ktx_file.h"
+#include "state_cache.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// path of the image of a texture name, trying the extensions the game's images use; empty if there's none
+static std::string findImage(const char* textureDir, const std::string& name)
+{
+    for (const char* extension : { ".png", ".jpg", ".jpeg" })
+    {
+        std::string file = std::string(textureDir) + "/" + name + extension;
+        if (std::ifstream(file))
+            return file;
+    }
+    return std::string();
+}
+
+
+MaterialLibrary::MaterialLibrary()
+    : defaultMaterial(0)
+{
+    glGenBuffers(1, &this->UBO);
+}
+
+MaterialLibrary::~MaterialLibrary()
+{
+    glDeleteBuffers(1, &this->UBO);
+    glDeleteTextures(1, &this->Texture.ID);
+    // deleted objects were unbound by the context behind the state cache's back
+    StateCache::Invalidate();
+}
+
+bool MaterialLibrary::Load(const char* file, const char* textureDir)
+{
+    std::ifstream stream(file);
+    if (!stream)
+    {
+        std::cout << "ERROR::MATERIALS: Failed to read " << file << std::endl;
+        return false;
+    }
+    this->Materials.clear();
+    this->codes.clear();
+    this->defaultMaterial = 0;
+    std::vector<std::string> images; // one per layer
+    std::string line;
+    for (unsigned int number = 1; std::getline(stream, line); ++number)
+    {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string code;
+        Material material;
+        if (!(words >> code))
+            continue; // empty line
+        if (!(words >> material.Texture >> material.Color.r >> material.Color.g >> material.Color.b >> material.Solid)
+            || (code != "default" && code.find_first_not_of("0123456789") != std::string::npos))
+        {
+            std::cout << "ERROR::MATERIALS: Invalid material in " << file << " line " << number << std::endl;
+            continue;
+        }
+        if (this->Materials.size() == MAX_MATERIALS)
+        {
+            std::cout << "ERROR::MATERIALS: More than " << MAX_MATERIALS << " materials in " << file << std::endl;
+            break;
+        }
+        std::vector<std::string>::iterator image = std::find(images.begin(), images.end(), material.Texture);
+        material.Layer = static_cast<unsigned int>(image - images.begin());
+        if (image == images.end())
+            images.push_back(material.Texture);
+        if (code == "default")
+            this->defaultMaterial = static_cast<unsigned int>(this->Materials.size());
+        else
+            this->codes[std::stoul(code)] = static_cast<unsigned int>(this->Materials.size());
+        this->Materials.push_back(material);
+    }
+    this->loadLayers(images, textureDir);
+    // the table as the shader sees it: <vec3 color, layer> per material, padded to the size of the block
+    std::vector<glm::vec4> table(MAX_MATERIALS, glm::vec4(0.0f));
+    for (unsigned int i = 0; i < this->Materials.size(); ++i)
+        table[i] = glm::vec4(this->Materials[i].Color, static_cast<float>(this->Materials[i].Layer));
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, table.size() * sizeof(glm::vec4), table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return true;
+}
+
+unsigned int MaterialLibrary::Find(unsigned int code) const
+{
+    std::map<unsigned int, unsigned int>::const_iterator material = this->codes.find(code);
+    return material != this->codes.end() ? material->second : this->defaultMaterial;
+}
+
+void MaterialLibrary::Bind() const
+{
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Texture.ID);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, this->UBO);
+}
+
+void MaterialLibrary::loadLayers(const std::vector<std::string>& images, const char* textureDir)
+{
+    unsigned int layers = static_cast<unsigned int>(images.size());
+    if (layers == 0)
+        return;
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Texture.ID);
+    // block compressed if every image has a KTX file of the same format and size that the context supports
+    std::vector<KtxImage> compressed(layers);
+    bool useCompressed = true;
+    for (unsigned int i = 0; i < layers && useCompressed; ++i)
+    {
+        std::string file = std::string(textureDir) + "/" + images[i] + ".ktx";
+        useCompressed = ReadKtx(file.c_str(), compressed[i]) && compressed[i].InternalFormat == compressed[0].InternalFormat
+            && compressed[i].Width == compressed[0].Width && compressed[i].Height == compressed[0].Height
+            && compressed[i].Levels.size() == compressed[0].Levels.size();
+    }
+    if (useCompressed && CompressedFormatSupported(compressed[0].InternalFormat))
+    {
+        const KtxImage& first = compressed[0];
+        unsigned int levels = static_cast<unsigned int>(first.Levels.size());
+        for (unsigned int level = 0; level < levels; ++level)
+        {
+            // the layers of a level follow each other
+            std::vector<unsigned char> data;
+            for (const KtxImage& image : compressed)
+                data.insert(data.end(), image.Levels[level].begin(), image.Levels[level].end());
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, first.InternalFormat, std::max(first.Width >> level, 1u), std::max(first.Height >> level, 1u), layers, 0,
+                static_cast<GLsizei>(data.size()), data.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        this->Texture.Internal_Format = first.InternalFormat;
+        this->Texture.Width = first.Width;
+        this->Texture.Height = first.Height;
+    }
+    else
+    {
+        // the images as they are, the first one that loads decides the size of the layers
+        int width = 0, height = 0;
+        std::vector<unsigned char> pixels;
+        for (unsigned int i = 0; i < layers; ++i)
+        {
+            std::string file = findImage(textureDir, images[i]);
+            int imageWidth, imageHeight, channels;
+            unsigned char* data = file.empty() ? nullptr : stbi_load(file.c_str(), &imageWidth, &imageHeight, &channels, 4);
+            if (!data)
+            {
+                std::cout << "ERROR::MATERIALS: Failed to load texture " << images[i] << std::endl;
+                continue;
+            }
+            if (pixels.empty())
+            {
+                width = imageWidth;
+                height = imageHeight;
+                pixels.assign(static_cast<std::size_t>(width) * height * 4 * layers, 0);
+            }
+            if (imageWidth == width && imageHeight == height)
+                std::copy(data, data + width * height * 4, pixels.begin() + static_cast<std::size_t>(width) * height * 4 * i);
+            else
+                std::cout << "ERROR::MATERIALS: Texture " << images[i] << " isn't " << width << "x" << height << " like the others" << std::endl;
+            stbi_image_free(data);
+        }
+        if (pixels.empty())
+            return;
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        this->Texture.Internal_Format = GL_RGBA8;
+        this->Texture.Width = width;
+        this->Texture.Height = height;
+    }
+    this->Texture.Image_Format = GL_RGBA;
+    this->Texture.Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, this->Texture.Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, this->Texture.Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, this->Texture.Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, this->Texture.Filter_Max);
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef MATERIAL_LIBRARY_H
+#define MATERIAL_LIBRARY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+
+
+// MaterialLibrary holds the appearances a brick can have, loaded from a
+// table that maps the tile codes of the level files to a texture, a color
+// and whether the brick is solid. The textures become the layers of one
+// array texture (a texture used by several materials is stored once) and
+// the table is uploaded into a uniform buffer, so a brick only carries the
+// index of its material and any mix of materials renders in a single
+// instanced draw without binding another texture.
+//
+// All textures have to be the same size. The layers are block compressed
+// with mipmaps if every texture has a KTX version in the same format (see
+// CompressTextures), otherwise the images are loaded as they are and their
+// mipmaps are generated.
+//
+// Table lines, '#' starts a comment:
+//   <tile code> <texture> <red> <green> <blue> <solid>
+// where the texture is the name of an image in the texture folder without
+// extension, and tile code "default" is used for codes without a line.
+class MaterialLibrary
+{
+public:
+    // most materials the uniform buffer holds (MAX_MATERIALS in brick.vs)
+    static const unsigned int MAX_MATERIALS = 256;
+    // uniform buffer binding point of the table (the "Materials" block in brick.vs)
+    static const unsigned int BINDING = 0;
+    struct Material {
+        std::string  Texture; // image name
+        unsigned int Layer;   // layer of the image in the array texture
+        glm::vec3    Color;
+        bool         Solid;
+    };
+    // materials in the order of the table
+    std::vector<Material> Materials;
+    // the array texture, wrapped to be handed around like the other textures; it has to be bound as GL_TEXTURE_2D_ARRAY
+    Texture2D Texture;
+    // constructor/destructor
+    MaterialLibrary();
+    ~MaterialLibrary();
+    // loads the table and the textures it refers to from textureDir; returns false if the table can't be read
+    bool Load(const char* file, const char* textureDir);
+    // index of the material of a tile code, the default material if the code has none
+    unsigned int Find(unsigned int code) const;
+    // binds the array texture to the active texture unit and the table to BINDING
+    void Bind() const;
+private:
+    unsigned int                         UBO;
+    std::map<unsigned int, unsigned int> codes; // tile code -> material index
+    unsigned int                         defaultMaterial;
+    // fills the array texture with one layer per image
+    void loadLayers(const std::vector<std::string>& images, const char* textureDir);
+};
+
+#endif
\ No newline at end of file
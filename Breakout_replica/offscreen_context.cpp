@@ -0,0 +1,150 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "offscreen_context.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// EGL_MESA_platform_surfaceless: a display that needs no window system at all
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+// returns the surfaceless display if the platform is available, the default display otherwise
+static EGLDisplay openDisplay()
+{
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+        {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+                return display;
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+        return display;
+    return EGL_NO_DISPLAY;
+}
+#endif
+
+
+OffscreenContext::OffscreenContext()
+    : display(nullptr), surface(nullptr), context(nullptr), window(nullptr)
+{
+
+}
+
+OffscreenContext::~OffscreenContext()
+{
+#ifdef __linux__
+    if (this->display)
+    {
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (this->context)
+            eglDestroyContext(this->display, this->context);
+        if (this->surface)
+            eglDestroySurface(this->display, this->surface);
+        eglTerminate(this->display);
+    }
+#endif
+    if (this->window)
+    {
+        glfwDestroyWindow(this->window);
+        glfwTerminate();
+    }
+}
+
+bool OffscreenContext::Create(unsigned int width, unsigned int height, int samples)
+{
+#ifdef __linux__
+    this->display = openDisplay();
+    if (!this->display)
+    {
+        std::cout << "ERROR::OFFSCREEN: Failed to open an EGL display" << std::endl;
+        return false;
+    }
+    // a multisampled config if there is one, any RGB8 pbuffer config otherwise
+    EGLint attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_SAMPLE_BUFFERS, samples > 1 ? 1 : 0,
+        EGL_SAMPLES, samples > 1 ? samples : 0,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(this->display, attributes, &config, 1, &configCount) || configCount == 0)
+    {
+        attributes[9] = attributes[11] = 0; // drop EGL_SAMPLE_BUFFERS and EGL_SAMPLES
+        if (!eglChooseConfig(this->display, attributes, &config, 1, &configCount) || configCount == 0)
+        {
+            std::cout << "ERROR::OFFSCREEN: No EGL config supports OpenGL pbuffers" << std::endl;
+            return false;
+        }
+    }
+    EGLint surfaceAttributes[] = { EGL_WIDTH, static_cast<EGLint>(width), EGL_HEIGHT, static_cast<EGLint>(height), EGL_NONE };
+    this->surface = eglCreatePbufferSurface(this->display, config, surfaceAttributes);
+    eglBindAPI(EGL_OPENGL_API);
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    this->context = eglCreateContext(this->display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (this->surface == EGL_NO_SURFACE || this->context == EGL_NO_CONTEXT || !eglMakeCurrent(this->display, this->surface, this->surface, this->context))
+    {
+        std::cout << "ERROR::OFFSCREEN: Failed to create an OpenGL 3.3 core pbuffer context" << std::endl;
+        return false;
+    }
+    return true;
+#else
+    if (!glfwInit())
+        return false;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    glfwWindowHint(GLFW_VISIBLE, false);
+    glfwWindowHint(GLFW_RESIZABLE, false);
+    glfwWindowHint(GLFW_SAMPLES, samples);
+    this->window = glfwCreateWindow(width, height, "Breakout", nullptr, nullptr);
+    if (!this->window)
+    {
+        std::cout << "ERROR::OFFSCREEN: Failed to create a hidden window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(this->window);
+    return true;
+#endif
+}
+
+void* OffscreenContext::GetProcAddress(const char* name)
+{
+#ifdef __linux__
+    return (void*)eglGetProcAddress(name);
+#else
+    return (void*)glfwGetProcAddress(name);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+struct GLFWwindow;
+
+
+// An OpenGL 3.3 core context without a visible window, for headless runs.
+// On Linux it's an EGL pbuffer context, preferring Mesa's surfaceless
+// platform, so it needs neither a display server nor a GPU (llvmpipe
+// renders it). Elsewhere it falls back to a hidden GLFW window. The
+// default framebuffer is the pbuffer (or the hidden window's back
+// buffer) and is read back with glReadPixels.
+class OffscreenContext
+{
+public:
+    // constructor/destructor
+    OffscreenContext();
+    ~OffscreenContext();
+    // creates the context with a width x height default framebuffer and makes it current; returns false on failure
+    bool Create(unsigned int width, unsigned int height, int samples);
+    // loads an OpenGL function of the current context (for gladLoadGLLoader)
+    static void* GetProcAddress(const char* name);
+private:
+    // EGL handles, kept opaque so users of the context don't need EGL's headers
+    void*       display;
+    void*       surface;
+    void*       context;
+    // hidden window on platforms without EGL
+    GLFWwindow* window;
+};
+
+#endif
\ No newline at end of file
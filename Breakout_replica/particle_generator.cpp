@@ -7,59 +7,133 @@
 ** option) any later version.
 ******************************************************************/
 #include "particle_generator.h"
+#include "resource_manager.h"
+#include "state_cache.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
-	: shader(shader), texture(texture), amount(amount) {
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+// how long a particle lives, in seconds
+const float PARTICLE_LIFE = 1.0f;
+// edge length of a particle's quad
+const float PARTICLE_SIZE = 10.0f;
+// top speed of a burst's particles
+const float BURST_SPEED = 150.0f;
+// bounds that contain nothing
+const glm::vec2 EMPTY_MIN(std::numeric_limits<float>::max());
+const glm::vec2 EMPTY_MAX(-std::numeric_limits<float>::max());
+
+ParticleGenerator::ParticleGenerator(Shader shader, Shader updateShader, TextureHandle texture, unsigned int amount)
+	: shader(shader), updateShader(updateShader), texture(texture), amount(amount), spawnCursor(0), boundsAge(0.0f), current(0) {
+	this->spawnMin[0] = this->spawnMin[1] = EMPTY_MIN;
+	this->spawnMax[0] = this->spawnMax[1] = EMPTY_MAX;
+	this->dtUniform = this->updateShader.GetUniform<float>("dt");
 	this->init();
 	initialSize = amount;
 }
 
+ParticleGenerator::~ParticleGenerator() {
+	glDeleteVertexArrays(2, this->VAO);
+	glDeleteVertexArrays(2, this->updateVAO);
+	glDeleteBuffers(2, this->VBO);
+	glDeleteBuffers(1, &this->quadVBO);
+	// the deleted vertex arrays were unbound behind the state cache's back, new ones may reuse their names
+	StateCache::Invalidate();
+}
+
 void ParticleGenerator::Update(float dt, GameObject& object, unsigned int newParticles, glm::vec2 offset) {
-	// add new particles
+	// once a lifetime has passed the older bounds only hold dead particles
+	this->boundsAge += dt;
+	if (this->boundsAge >= PARTICLE_LIFE) {
+		this->spawnMin[1] = this->spawnMin[0];
+		this->spawnMax[1] = this->spawnMax[0];
+		this->spawnMin[0] = EMPTY_MIN;
+		this->spawnMax[0] = EMPTY_MAX;
+		this->boundsAge = 0.0f;
+	}
 	for (unsigned int i = 0; i < newParticles; ++i) {
-		int ununsedParticle = this->firstUnusedParticle();
-		this->respawnParticle(this->particles[ununsedParticle], object, offset);
+		Particle particle;
+		this->respawnParticle(particle, object, offset);
+		this->stage(particle);
+	}
+	// add the new particles by appending them to the ring of the current buffer
+	newParticles = static_cast<unsigned int>(this->spawned.size());
+	if (newParticles > 0) {
+		unsigned int first = std::min(newParticles, this->amount - this->spawnCursor);
+		glBindBuffer(GL_ARRAY_BUFFER, this->VBO[this->current]);
+		glBufferSubData(GL_ARRAY_BUFFER, this->spawnCursor * sizeof(Particle), first * sizeof(Particle), &this->spawned[0]);
+		if (first < newParticles) // wrap around to the start of the ring
+			glBufferSubData(GL_ARRAY_BUFFER, 0, (newParticles - first) * sizeof(Particle), &this->spawned[first]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		this->spawnCursor = (this->spawnCursor + newParticles) % this->amount;
+		this->spawned.clear();
 	}
-	// update all particles
-	for (unsigned int i = 0; i < this->amount; ++i) {
-		Particle& p = this->particles[i];
-		p.Life -= dt; // reduce life
-		if (p.Life > 0.0f) {
-			// particles is alive, thus update
-			p.Position -= p.Velocity * dt;
-			p.Color.a -= dt * 2.5f;
-		}
+	// update all particles on the GPU, capturing the result into the other buffer
+	unsigned int next = 1 - this->current;
+	this->updateShader.Use();
+	this->updateShader.Set(this->dtUniform, dt);
+	glEnable(GL_RASTERIZER_DISCARD);
+	StateCache::BindVertexArray(this->updateVAO[this->current]);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->VBO[next]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, this->amount);
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+	this->current = next;
+}
+
+void ParticleGenerator::Burst(GameObject& object, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		Particle particle;
+		float angle = (rand() % 360) * glm::radians(1.0f);
+		float speed = BURST_SPEED * ((rand() % 100) + 1) / 100.0f;
+		float rColor = 0.5f + ((rand() % 100) / 100.0f);
+		particle.Position = object.Position + object.Size * glm::vec2((rand() % 100) / 100.0f, (rand() % 100) / 100.0f);
+		particle.Velocity = glm::vec2(std::cos(angle), std::sin(angle)) * speed;
+		particle.Color = glm::vec4(object.Color * rColor, 1.0f);
+		particle.Life = PARTICLE_LIFE;
+		this->stage(particle);
 	}
 }
 
 // render all particles
 void ParticleGenerator::Draw() {
-	// use additive blending to give it a 'glow' effect
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 	this->shader.Use();
-	for (Particle particle : this->particles) {
-		if (particle.Life > 0.0f) {
-			this->shader.SetVector2f("offset", particle.Position);
-			this->shader.SetVector4f("color", particle.Color);
-			this->texture.Bind();
-			glBindVertexArray(this->VAO);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-			glBindVertexArray(0);
-		}
-	}
-	// dont forget to reset to default blending mode
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	StateCache::ActiveTexture(GL_TEXTURE0);
+	ResourceManager::GetTexture(this->texture).Bind();
+	StateCache::BindVertexArray(this->VAO[this->current]);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, this->amount);
 }
 
-// render all particles
+void ParticleGenerator::Submit(RenderQueue& queue, unsigned int layer) {
+	// use additive blending to give it a 'glow' effect
+	queue.Submit(layer, RenderQueue::BLEND_ADDITIVE, this->shader.ID, ResourceManager::GetTexture(this->texture).ID, [this]() { this->Draw(); });
+}
+
+// reset particles
 void ParticleGenerator::Reset() {
-	this->particles.clear();
-	this->particles.resize(initialSize);
+	std::vector<Particle> particles(this->amount);
+	for (unsigned int i = 0; i < 2; ++i) {
+		glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, this->amount * sizeof(Particle), particles.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	this->spawned.clear();
+	this->spawnCursor = 0;
+	this->spawnMin[0] = this->spawnMin[1] = EMPTY_MIN;
+	this->spawnMax[0] = this->spawnMax[1] = EMPTY_MAX;
+	this->boundsAge = 0.0f;
+}
+
+glm::vec4 ParticleGenerator::Bounds() const {
+	return glm::vec4(glm::min(this->spawnMin[0], this->spawnMin[1]), glm::max(this->spawnMax[0], this->spawnMax[1]));
 }
 
 void ParticleGenerator::init() {
 	// set up mesh and attribute properties
-	unsigned int VBO;
 	float particle_quad[] = {
 		0.0f, 1.0f, 0.0f, 1.0f,
 		1.0f, 0.0f, 1.0f, 0.0f,
@@ -69,43 +143,46 @@ void ParticleGenerator::init() {
 		1.0f, 1.0f, 1.0f, 1.0f,
 		1.0f, 0.0f, 1.0f, 0.0f
 	};
-	glGenVertexArrays(1, &this->VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(this->VAO);
-	// fill mesh buffer
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glGenBuffers(1, &this->quadVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
-	// set mesh attributes
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-	glBindVertexArray(0);
 
-	// create this->amount default particle instances
-	for (unsigned int i = 0; i < this->amount; ++i) {
-		this->particles.push_back(Particle());
+	// create this->amount default (dead) particles in both buffers
+	std::vector<Particle> particles(this->amount);
+	glGenBuffers(2, this->VBO);
+	glGenVertexArrays(2, this->VAO);
+	glGenVertexArrays(2, this->updateVAO);
+	for (unsigned int i = 0; i < 2; ++i) {
+		glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+		glBufferData(GL_ARRAY_BUFFER, this->amount * sizeof(Particle), particles.data(), GL_DYNAMIC_COPY);
+		// transform feedback input: one vertex per particle
+		StateCache::BindVertexArray(this->updateVAO[i]);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Velocity));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Color));
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Life));
+		// rendering: the quad per vertex, the particle per instance
+		StateCache::BindVertexArray(this->VAO[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Position));
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Color));
+		glVertexAttribDivisor(2, 1);
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Life));
+		glVertexAttribDivisor(3, 1);
 	}
-}
-
-// stores the index of the last particle used (for quick access to next dead particle)
-unsigned int lastUsedParticle = 0;
-unsigned int ParticleGenerator::firstUnusedParticle() {
-	// first search from last used particle, this will usually return almost instantly
-	for (unsigned int i = lastUsedParticle; i < this->amount; ++i) {
-		if (this->particles[i].Life <= 0.0f) {
-			lastUsedParticle = i;
-			return i;
-		}
-	}
-	// otherwise, do a linear search
-	for (unsigned int i = 0; i < lastUsedParticle; ++i) {
-		if (this->particles[i].Life <= 0.0f) {
-			lastUsedParticle = i;
-			return i;
-		}
-	}
-	// all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-	lastUsedParticle = 0;
-	return 0;
+	StateCache::BindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void ParticleGenerator::respawnParticle(Particle& particle, GameObject& object, glm::vec2 offset) {
@@ -113,6 +190,17 @@ void ParticleGenerator::respawnParticle(Particle& particle, GameObject& object,
 	float rColor = 0.5f + ((rand() % 100) / 100.0f);
 	particle.Position = object.Position + random + offset;
 	particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-	particle.Life = 1.0f;
+	particle.Life = PARTICLE_LIFE;
 	particle.Velocity = object.Velocity * 0.1f;
+}
+
+void ParticleGenerator::stage(const Particle& particle) {
+	// a ring can't take more new particles than it holds
+	if (this->spawned.size() >= this->amount)
+		return;
+	this->spawned.push_back(particle);
+	// particles move against their velocity (see particle_update.vs) until they die
+	glm::vec2 end = particle.Position - particle.Velocity * PARTICLE_LIFE;
+	this->spawnMin[0] = glm::min(this->spawnMin[0], glm::min(particle.Position, end));
+	this->spawnMax[0] = glm::max(this->spawnMax[0], glm::max(particle.Position, end) + PARTICLE_SIZE);
 }
\ No newline at end of file
@@ -13,9 +13,11 @@
 #include "shader.h"
 #include "texture.h"
 #include "game_object.h"
+#include "render_queue.h"
 #include <vector>
 
-// Represents a single particle and its state
+// Represents a single particle and its state; also the vertex layout of
+// the particle buffers on the GPU
 struct Particle {
     glm::vec2 Position, Velocity;
     glm::vec4 Color;
@@ -24,31 +26,55 @@ struct Particle {
     Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
 };
 
+// ParticleGenerator keeps all particles in a pair of GPU buffers. New
+// particles are appended into the buffers as a ring, all particles are
+// advanced on the GPU with transform feedback (ping-ponging between the
+// two buffers) and rendered with a single instanced draw call, so the
+// CPU cost does not grow with the amount of particles.
 class ParticleGenerator {
 public:
     unsigned int initialSize;
     // constructor
-    ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount);
-    // update all particles
+    ParticleGenerator(Shader shader, Shader updateShader, TextureHandle texture, unsigned int amount);
+    // destructor
+    ~ParticleGenerator();
+    // update all particles, spawning newParticles behind the object along with any queued bursts
     void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
-    // render all particles
+    // queues a burst of particles scattered over the object and flung outwards; spawned by the next Update
+    void Burst(GameObject &object, unsigned int count);
+    // render all particles, expects additive blending to be set
     void Draw();
+    // queues the particles into a layer of a render queue, additively blended
+    void Submit(RenderQueue& queue, unsigned int layer);
+    // area <vec2 min, vec2 max> the living particles may cover; min > max if there are none
+    glm::vec4 Bounds() const;
     // reset particles
     void Reset();
 private:
     // state
-    std::vector<Particle> particles;
+    std::vector<Particle> spawned; // staging storage for the particles spawned until the next update
     unsigned int amount;
+    unsigned int spawnCursor; // next ring slot to spawn a particle into
+    // the particles are only known to the GPU, so the CPU tracks the area covered by
+    // everything spawned within the current and the previous lifetime instead
+    glm::vec2 spawnMin[2], spawnMax[2];
+    float boundsAge; // time since the current bounds were started
     //render state
     Shader shader;
-    Texture2D texture;
-    unsigned int VAO;
+    Shader updateShader;
+    Uniform<float> dtUniform;
+    TextureHandle texture;
+    unsigned int current; // index of the buffer holding the latest particle state
+    unsigned int quadVBO;
+    unsigned int VBO[2];
+    unsigned int VAO[2]; // instanced quad rendering per buffer
+    unsigned int updateVAO[2]; // transform feedback input per buffer
     // unitializes buffer and vertex attributes
     void init();
-    // returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-    unsigned int firstUnusedParticle();
     // respawns particle
     void respawnParticle(Particle& particle, GameObject& object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // stages a new particle for the next upload and grows the bounds by its path
+    void stage(const Particle& particle);
 };
 
 #endif // !PARTICLEGENERATOR_H
\ No newline at end of file
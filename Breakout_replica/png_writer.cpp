@@ -0,0 +1,101 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "png_writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// CRC-32 as used by PNG chunks
+static std::uint32_t crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0)
+{
+    static std::uint32_t table[256] = {};
+    if (table[1] == 0)
+    {
+        for (std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void appendUint32(std::vector<unsigned char>& out, std::uint32_t value)
+{
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// appends a chunk: length, type, data and the CRC over type and data
+static void appendChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+{
+    appendUint32(out, static_cast<std::uint32_t>(data.size()));
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendUint32(out, crc32(&out[start], out.size() - start));
+}
+
+
+bool WritePng(const char* file, unsigned int width, unsigned int height, const unsigned char* pixels)
+{
+    // scanlines: a filter type byte (0, none) followed by the row's pixels
+    std::size_t stride = static_cast<std::size_t>(width) * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * height);
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * stride, pixels + (y + 1) * stride);
+    }
+    // zlib stream of stored (uncompressed) deflate blocks of at most 65535 bytes each
+    std::vector<unsigned char> idat = { 0x78, 0x01 };
+    std::size_t offset = 0;
+    do
+    {
+        std::size_t size = std::min<std::size_t>(raw.size() - offset, 65535);
+        bool last = offset + size == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<unsigned char>(size));
+        idat.push_back(static_cast<unsigned char>(size >> 8));
+        idat.push_back(static_cast<unsigned char>(~size));
+        idat.push_back(static_cast<unsigned char>(~size >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    } while (offset < raw.size());
+    std::uint32_t a = 1, b = 0; // Adler-32 of the uncompressed data
+    for (unsigned char byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendUint32(idat, (b << 16) | a);
+    // header: size, 8 bits per channel, truecolor, default compression/filter, no interlacing
+    std::vector<unsigned char> header;
+    appendUint32(header, width);
+    appendUint32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", idat);
+    appendChunk(png, "IEND", {});
+
+    std::ofstream out(file, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return static_cast<bool>(out);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+
+// Writes 8-bit RGB pixels (rows from top to bottom, tightly packed) to a
+// PNG file. The image data is stored without compression, which keeps the
+// writer tiny; any PNG reader (stb_image included) can load the result.
+// Returns false if the file can't be written.
+bool WritePng(const char* file, unsigned int width, unsigned int height, const unsigned char* pixels);
+
+#endif
\ No newline at end of file
@@ -7,89 +7,62 @@
 ** option) any later version.
 ******************************************************************/
 #include "post_processor.h"
+#include "resource_manager.h"
+#include "state_cache.h"
 
 #include <iostream>
+#include <string>
 
-PostProcessor::PostProcessor(Shader shader, unsigned int width, unsigned int height)
-    : PostProcessingShader(shader), Texture(), Width(width), Height(height), Confuse(false), Chaos(false), Shake(false)
+PostProcessor::PostProcessor(unsigned int width, unsigned int height)
+    : Width(width), Height(height), Confuse(false), Chaos(false), Shake(false)
 {
-    // initialize renderbuffer/framebuffer object
-    glGenFramebuffers(1, &this->MSFBO);
-    glGenFramebuffers(1, &this->FBO);
-    glGenRenderbuffers(1, &this->RBO);
-    // initialize renderbuffer storage with a multisampled color buffer (don't need a depth/stencil buffer)
-    glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGB, width, height); // allocate storage for render buffer object
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO); // attach MS render buffer object to framebuffer
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::POSTPROCESSOR: Failed to initialize MSFBO" << std::endl;
-    // also initialize the FBO/texture to blit multisampled color-buffer to; used for shader operations (for postprocessing effects)
-    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
-    this->Texture.Generate(width, height, NULL);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture.ID, 0); // attach texture to framebuffer as its color attachment
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::POSTPROCESSOR: Failed to initialize FBO" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    // initialize render data and uniforms
+    // initialize render data and shaders
     this->initRenderData();
-    this->PostProcessingShader.SetInteger("scene", 0, true);
-    float offset = 1.0f / 300.0f;
-    float offsets[9][2] = {
-        { -offset,  offset  },  // top-left
-        {  0.0f,    offset  },  // top-center
-        {  offset,  offset  },  // top-right
-        { -offset,  0.0f    },  // center-left
-        {  0.0f,    0.0f    },  // center-center
-        {  offset,  0.0f    },  // center - right
-        { -offset, -offset  },  // bottom-left
-        {  0.0f,   -offset  },  // bottom-center
-        {  offset, -offset  }   // bottom-right    
-    };
-    glUniform2fv(glGetUniformLocation(this->PostProcessingShader.ID, "offsets"), 9, (float*)offsets);
-    int edge_kernel[9] = {
-        -1, -1, -1,
-        -1,  8, -1,
-        -1, -1, -1
-    };
-    glUniform1iv(glGetUniformLocation(this->PostProcessingShader.ID, "edge_kernel"), 9, edge_kernel);
-    float blur_kernel[9] = {
-        1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
-        2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
-        1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
-    };
-    glUniform1fv(glGetUniformLocation(this->PostProcessingShader.ID, "blur_kernel"), 9, blur_kernel);
+    this->loadShaders();
 }
 
-void PostProcessor::BeginRender()
+void PostProcessor::Render(unsigned int scene, float time)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // select the permutation of the enabled effects and set its uniforms
+    unsigned int effects = (this->Chaos ? EFFECT_CHAOS : 0) | (this->Confuse ? EFFECT_CONFUSE : 0) | (this->Shake ? EFFECT_SHAKE : 0);
+    Shader& shader = this->PostProcessingShaders[effects];
+    shader.Use();
+    shader.Set(this->timeUniforms[effects], time);
+    // render textured quad
+    StateCache::ActiveTexture(GL_TEXTURE0);
+    StateCache::BindTexture(GL_TEXTURE_2D, scene);
+    StateCache::BindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
 }
-void PostProcessor::EndRender()
+
+bool PostProcessor::EffectsActive() const
 {
-    // now resolve multisampled color-buffer into intermediate FBO to store to texture
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
-    glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // binds both READ and WRITE framebuffer to default framebuffer
+    return this->Confuse || this->Chaos || this->Shake;
 }
 
-void PostProcessor::Render(float time)
+void PostProcessor::loadShaders()
 {
-    // set uniforms/options
-    this->PostProcessingShader.Use();
-    this->PostProcessingShader.SetFloat("time", time);
-    this->PostProcessingShader.SetInteger("confuse", this->Confuse);
-    this->PostProcessingShader.SetInteger("chaos", this->Chaos);
-    this->PostProcessingShader.SetInteger("shake", this->Shake);
-    // render textured quad
-    glActiveTexture(GL_TEXTURE0);
-    this->Texture.Bind();
-    glBindVertexArray(this->VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    for (unsigned int effects = 0; effects < EFFECT_COMBINATIONS; ++effects)
+    {
+        std::string defines;
+        if (effects & EFFECT_CHAOS)
+            defines += "#define CHAOS\n";
+        if (effects & EFFECT_CONFUSE)
+            defines += "#define CONFUSE\n";
+        if (effects & EFFECT_SHAKE)
+            defines += "#define SHAKE\n";
+        // compiled once and shared by all post-processors (one per game session)
+        std::string name = "postprocessing" + std::to_string(effects);
+        Shader& shader = this->PostProcessingShaders[effects];
+        if (ResourceManager::HasShader(name))
+            shader = ResourceManager::GetShader(name);
+        else
+        {
+            shader = ResourceManager::LoadShader("shaders/post_processing.vs", "shaders/post_processing.frag", nullptr, name, defines.c_str());
+            shader.SetInteger("scene", 0, true);
+        }
+        this->timeUniforms[effects] = shader.GetUniform<float>("time");
+    }
 }
 
 void PostProcessor::initRenderData()
@@ -112,9 +85,9 @@ void PostProcessor::initRenderData()
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->VAO);
+    StateCache::BindVertexArray(this->VAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    StateCache::BindVertexArray(0);
 }
\ No newline at end of file
@@ -20,33 +20,45 @@
 // PostProcessor hosts all PostProcessing effects for the Breakout
 // Game. It renders the game on a textured quad after which one can
 // enable specific effects by enabling either the Confuse, Chaos or 
-// Shake boolean. 
-// It is required to call BeginRender() before rendering the game
-// and EndRender() after rendering the game for the class to work.
+// Shake boolean. Every combination of effects has its own permutation
+// of the post-processing shader, compiled with only the code (and
+// constant kernels) those effects need; Render() picks it from the flags.
+// The permutations are compiled by the first PostProcessor and shared by
+// all later ones, so each game session can have its own effect flags.
+// The scene texture it renders comes from the frame graph's scene pass;
+// it may have a different resolution than the target, it's filtered
+// bilinearly into the bound viewport.
+// While no effect is enabled the game should be rendered straight into
+// the (multisampled) default framebuffer instead, see EffectsActive().
 class PostProcessor
 {
 public:
+    // effect flags, combined into an index into the shader permutations
+    enum Effect {
+        EFFECT_CHAOS   = 1,
+        EFFECT_CONFUSE = 2,
+        EFFECT_SHAKE   = 4,
+        EFFECT_COMBINATIONS = 8
+    };
     // state
-    Shader PostProcessingShader;
-    Texture2D Texture;
+    Shader PostProcessingShaders[EFFECT_COMBINATIONS];
     unsigned int Width, Height;
     // options
     bool Confuse, Chaos, Shake;
     // constructor
-    PostProcessor(Shader shader, unsigned int width, unsigned int height);
-    // prepares the postprocessor's framebuffer operations before rendering the game
-    void BeginRender();
-    // should be called after rendering the game, so it stores all the rendered data into a texture object
-    void EndRender();
-    // renders the PostProcessor texture quad (as a screen-encompassing large sprite)
-    void Render(float time);
+    PostProcessor(unsigned int width, unsigned int height);
+    // renders the scene texture as a screen-encompassing quad with the enabled effects applied
+    void Render(unsigned int scene, float time);
+    // returns true if any effect is enabled and the scene has to go through the offscreen pass
+    bool EffectsActive() const;
 private:
     // render state
-    unsigned int MSFBO, FBO; // MSFBO = Multisampled FBO. FBO is regular, used for blitting MS color-buffer to texture
-    unsigned int RBO; // RBO is used for multisampled color buffer
     unsigned int VAO;
+    Uniform<float> timeUniforms[EFFECT_COMBINATIONS];
     // initialize quad for rendering postprocessing texture
     void initRenderData();
+    // compiles the shader permutation of every combination of effects
+    void loadShaders();
 };
 
 #endif
\ No newline at end of file
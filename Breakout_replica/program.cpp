@@ -11,13 +11,29 @@
 
 #include "game.h"
 #include "resource_manager.h"
-
+#include "state_cache.h"
+#include "stream_buffer.h"
+#include "program_cache.h"
+#include "offscreen_context.h"
+#include "headless_runner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+// switches between windowed mode and fullscreen on the primary monitor
+void toggleFullscreen(GLFWwindow* window);
+// runs a script of frames without a window (see HeadlessRunner); returns the process exit code
+int runHeadless(const char* script, const char* goldenDir, bool updateGolden);
+// sets up the OpenGL state the game expects
+void configureOpenGL();
 
 // The Width of the screen
 const unsigned int SCREEN_WIDTH = 800;
@@ -28,7 +44,29 @@ Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
 int main(int argc, char* argv[])
 {
+    // Breakout [--sessions <count>] [--render-scale <scale>] [--headless <script> [--golden <dir>] [--update-golden]]
+    const char* script = nullptr;
+    const char* goldenDir = "benchmarks/golden";
+    bool updateGolden = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+            script = argv[++i];
+        else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+            goldenDir = argv[++i];
+        else if (std::strcmp(argv[i], "--update-golden") == 0)
+            updateGolden = true;
+        else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc)
+            Breakout.SessionCount = std::clamp(std::atoi(argv[++i]), 1, static_cast<int>(Game::MAX_SESSIONS));
+        else if (std::strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc)
+            Breakout.RenderScale = std::max(static_cast<float>(std::atof(argv[++i])), 0.1f);
+    }
+    if (script)
+        return runHeadless(script, goldenDir, updateGolden);
+
+#ifdef _WIN32
     ShowWindow(GetConsoleWindow(), SW_HIDE);
+#endif
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -36,7 +74,9 @@ int main(int argc, char* argv[])
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
-    glfwWindowHint(GLFW_RESIZABLE, false);
+    glfwWindowHint(GLFW_RESIZABLE, true);
+    // multisample the default framebuffer, the game renders straight into it while no effect is active
+    glfwWindowHint(GLFW_SAMPLES, 4);
 
     GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Breakout", nullptr, nullptr);
     glfwMakeContextCurrent(window);
@@ -53,12 +93,14 @@ int main(int argc, char* argv[])
 
     glfwSetKeyCallback(window, key_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // the framebuffer can be larger than the window (e.g. on retina displays)
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    Breakout.Resize(framebufferWidth, framebufferHeight);
 
     // OpenGL configuration
     // --------------------
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    configureOpenGL();
 
     // initialize game
     // ---------------
@@ -95,19 +137,57 @@ int main(int argc, char* argv[])
         glfwSwapBuffers(window);
     }
 
-    // delete all resources as loaded using the resource manager
-    // ---------------------------------------------------------
+    // delete the game's objects and all resources as loaded using the resource manager
+    // ---------------------------------------------------------------------------------
+    Breakout.Shutdown();
     ResourceManager::Clear();
 
     glfwTerminate();
     return 0;
 }
 
+int runHeadless(const char* script, const char* goldenDir, bool updateGolden)
+{
+    OffscreenContext context;
+    if (!context.Create(SCREEN_WIDTH, SCREEN_HEIGHT, 4))
+        return -1;
+    if (!gladLoadGLLoader(OffscreenContext::GetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    StreamBuffer::GetProcAddress = OffscreenContext::GetProcAddress;
+    ProgramCache::GetProcAddress = OffscreenContext::GetProcAddress;
+    configureOpenGL();
+
+    unsigned int failures = 0;
+    {
+        HeadlessRunner runner(Breakout, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (!runner.Load(script))
+            return -1;
+        Breakout.Init();
+        failures = runner.Run(goldenDir, updateGolden);
+    }
+    Breakout.Shutdown();
+    ResourceManager::Clear();
+    return failures == 0 ? 0 : 1;
+}
+
+void configureOpenGL()
+{
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glEnable(GL_MULTISAMPLE);
+    glEnable(GL_BLEND);
+    StateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
     // when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    if (key == GLFW_KEY_F11 && action == GLFW_PRESS)
+        toggleFullscreen(window);
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -124,4 +204,21 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    Breakout.Resize(width, height);
+}
+
+void toggleFullscreen(GLFWwindow* window)
+{
+    // where the window was before going fullscreen
+    static int windowX, windowY, windowWidth, windowHeight;
+    if (glfwGetWindowMonitor(window))
+    {
+        glfwSetWindowMonitor(window, nullptr, windowX, windowY, windowWidth, windowHeight, 0);
+        return;
+    }
+    glfwGetWindowPos(window, &windowX, &windowY);
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+    glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "program_cache.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// ARB_get_program_binary (core in OpenGL 4.1) isn't part of the loaded OpenGL 3.3 functions
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+struct ProgramBinaryFunctions {
+    PFNGLGETPROGRAMBINARYPROC  GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC     ProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+};
+
+// returns the program binary functions, all nullptr if the context can't save any binary format
+static ProgramBinaryFunctions loadProgramBinary()
+{
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 1);
+    int extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (int i = 0; i < extensionCount && !supported; ++i)
+        supported = std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_get_program_binary") == 0;
+    // drivers may support the functions without offering a single format to save in
+    int formats = 0;
+    if (supported)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+        return ProgramBinaryFunctions();
+    return ProgramBinaryFunctions {
+        (PFNGLGETPROGRAMBINARYPROC)ProgramCache::GetProcAddress("glGetProgramBinary"),
+        (PFNGLPROGRAMBINARYPROC)ProgramCache::GetProcAddress("glProgramBinary"),
+        (PFNGLPROGRAMPARAMETERIPROC)ProgramCache::GetProcAddress("glProgramParameteri")
+    };
+}
+
+static const ProgramBinaryFunctions& programBinary()
+{
+    static ProgramBinaryFunctions functions = loadProgramBinary();
+    return functions;
+}
+
+// 64-bit FNV-1a, continuing from hash
+static std::uint64_t fnv1a(const char* data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+{
+    for (std::size_t i = 0; i < size; ++i)
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    return hash;
+}
+
+GLADloadproc ProgramCache::GetProcAddress = (GLADloadproc)glfwGetProcAddress;
+std::string  ProgramCache::Directory = "shader_cache";
+
+
+std::uint64_t ProgramCache::Key(const std::vector<const char*>& parts)
+{
+    // the driver's identity first; the terminating null of every string keeps the parts apart
+    std::uint64_t hash = fnv1a(nullptr, 0);
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        if (value)
+            hash = fnv1a(value, std::strlen(value) + 1, hash);
+    }
+    for (const char* part : parts)
+        hash = part ? fnv1a(part, std::strlen(part) + 1, hash) : fnv1a("", 1, hash);
+    return hash;
+}
+
+unsigned int ProgramCache::Load(std::uint64_t key)
+{
+    if (!programBinary().ProgramBinary)
+        return 0;
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file)
+        return 0;
+    // the binary's format followed by the binary itself
+    GLenum format = 0;
+    if (!file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+        return 0;
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty())
+        return 0;
+    unsigned int program = glCreateProgram();
+    programBinary().ProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // rejected (e.g. written by another version of the driver), the caller compiles the program instead
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::Prepare(unsigned int program)
+{
+    if (programBinary().ProgramParameteri)
+        programBinary().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Store(unsigned int program, std::uint64_t key)
+{
+    if (!programBinary().GetProgramBinary)
+        return;
+    int success = 0, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!success || length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    programBinary().GetProgramBinary(program, length, &length, &format, binary.data());
+    std::error_code error;
+    std::filesystem::create_directories(Directory, error);
+    std::ofstream file(path(key), std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    if (!file)
+        std::cout << "ERROR::PROGRAMCACHE: Failed to write " << path(key) << std::endl;
+}
+
+std::string ProgramCache::path(std::uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return Directory + "/" + name;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// A static singleton ProgramCache class that keeps linked shader programs
+// on disk as driver binaries (ARB_get_program_binary, core in OpenGL 4.1),
+// so later runs skip compiling and linking them. Programs are stored under
+// a hash of their sources and of the driver's vendor, renderer and version
+// strings: changing a shader or the driver simply misses the cache. The
+// driver may still reject a binary it wrote itself (e.g. after an update
+// that kept its version string); the program is then compiled from source
+// and its cache entry replaced. Without support for program binaries Load
+// always misses and Store does nothing.
+// All functions are static and no public constructor is defined.
+class ProgramCache
+{
+public:
+    // loads the program binary functions, which glad's OpenGL 3.3 functions don't include; GLFW's
+    // loader unless the context wasn't created through GLFW (set it before loading shaders)
+    static GLADloadproc GetProcAddress;
+    // folder the binaries are kept in
+    static std::string Directory;
+    // key of a program: a hash of everything that goes into linking it (null parts count as empty) and of the driver
+    static std::uint64_t Key(const std::vector<const char*>& parts);
+    // creates a program from the binary cached under key; returns 0 if there is none or the driver rejects it
+    static unsigned int Load(std::uint64_t key);
+    // marks a program that's about to be linked so the driver keeps its binary retrievable
+    static void Prepare(unsigned int program);
+    // caches the binary of a program under key if it linked successfully
+    static void Store(unsigned int program, std::uint64_t key);
+private:
+    // private constructor, that is we do not want any actual program cache objects
+    ProgramCache() { }
+    // path of the file of a key
+    static std::string path(std::uint64_t key);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "render_queue.h"
+#include "state_cache.h"
+
+#include <algorithm>
+
+
+RenderQueue::RenderQueue(SpriteRenderer& renderer, unsigned int spriteProgram)
+    : renderer(renderer), spriteProgram(spriteProgram) { }
+
+void RenderQueue::Submit(unsigned int layer, const Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, unsigned int depth)
+{
+    this->order.push_back({ Key(layer, BLEND_ALPHA, this->spriteProgram, texture.ID, depth), static_cast<unsigned int>(this->commands.size()) });
+    this->commands.emplace_back();
+    Command& command = this->commands.back();
+    command.Texture = texture;
+    command.Position = position;
+    command.Size = size;
+    command.Rotate = rotate;
+    command.Color = color;
+}
+
+void RenderQueue::Submit(unsigned int layer, Blend blend, unsigned int program, unsigned int texture, std::function<void()> draw, unsigned int depth)
+{
+    this->order.push_back({ Key(layer, blend, program, texture, depth), static_cast<unsigned int>(this->commands.size()) });
+    this->commands.emplace_back();
+    this->commands.back().Draw = std::move(draw);
+}
+
+void RenderQueue::Execute()
+{
+    // ties are broken by submission order, which keeps the sort stable without std::stable_sort's buffer
+    std::sort(this->order.begin(), this->order.end(), [](const SortEntry& a, const SortEntry& b) {
+        return a.Key != b.Key ? a.Key < b.Key : a.Index < b.Index;
+    });
+    for (const SortEntry& entry : this->order)
+    {
+        if (((entry.Key >> 36) & 0xF) == BLEND_ADDITIVE)
+            StateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE);
+        else
+            StateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        Command& command = this->commands[entry.Index];
+        if (command.Draw)
+            command.Draw();
+        else
+            this->renderer.DrawSprite(command.Texture, command.Position, command.Size, command.Rotate, command.Color);
+    }
+    StateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    this->commands.clear();
+    this->order.clear();
+}
+
+std::uint64_t RenderQueue::Key(unsigned int layer, Blend blend, unsigned int program, unsigned int texture, unsigned int depth)
+{
+    return (static_cast<std::uint64_t>(layer & 0xFF) << 56)
+        | (static_cast<std::uint64_t>(depth & 0xFFFF) << 40)
+        | (static_cast<std::uint64_t>(blend & 0xF) << 36)
+        | (static_cast<std::uint64_t>(program & 0xFFF) << 24)
+        | static_cast<std::uint64_t>(texture & 0xFFFFFF);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "sprite_renderer.h"
+
+
+// RenderQueue collects the draws of a scene, each with a 64-bit sort key,
+// and executes them ordered by that key. From the most significant bits
+// down the key holds the layer, a depth, the blend mode, the shader
+// program and the texture:
+//
+//   63..56 layer | 55..40 depth | 39..36 blend | 35..24 program | 23..0 texture
+//
+// Layers are drawn back to front, and within a layer so are depths: draws
+// that overlap need different layers or depths. Draws of the same layer
+// and depth using the same state end up next to each other and the state
+// cache drops the changes between them. Draws with equal keys run in the
+// order they were submitted. The queue sets the blend mode of each draw
+// and leaves alpha blending set afterwards.
+class RenderQueue
+{
+public:
+    enum Blend { BLEND_ALPHA, BLEND_ADDITIVE };
+    // constructor, spriteProgram is the program the renderer draws sprites with
+    RenderQueue(SpriteRenderer& renderer, unsigned int spriteProgram);
+    // queues a sprite drawn with the sprite renderer (alpha blended)
+    void Submit(unsigned int layer, const Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), unsigned int depth = 0);
+    // queues a draw call of its own; program and texture are the ones it binds, for sorting
+    void Submit(unsigned int layer, Blend blend, unsigned int program, unsigned int texture, std::function<void()> draw, unsigned int depth = 0);
+    // sorts and executes the queued draws, then empties the queue
+    void Execute();
+    // packs the sort key of a draw
+    static std::uint64_t Key(unsigned int layer, Blend blend, unsigned int program, unsigned int texture, unsigned int depth);
+private:
+    struct Command {
+        // sprite draws
+        Texture2D             Texture;
+        glm::vec2             Position, Size;
+        float                 Rotate;
+        glm::vec3             Color;
+        // other draws (empty for sprites)
+        std::function<void()> Draw;
+    };
+    struct SortEntry {
+        std::uint64_t Key;
+        unsigned int  Index; // into commands, also the submission order
+    };
+    SpriteRenderer&        renderer;
+    unsigned int           spriteProgram;
+    // reused every frame, so submitting doesn't allocate once they've grown
+    std::vector<Command>   commands;
+    std::vector<SortEntry> order;
+};
+
+#endif
\ No newline at end of file
@@ -7,6 +7,8 @@
 ** option) any later version.
 ******************************************************************/
 #include "resource_manager.h"
+#include "state_cache.h"
+#include "ktx_file.h"
 
 #include <iostream>
 #include <sstream>
@@ -16,30 +18,118 @@
 #include "stb_image.h"
 
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+std::vector<Texture2D>                          ResourceManager::Textures;
+std::vector<Shader>                             ResourceManager::Shaders;
+TextureLoader*                                  ResourceManager::loader = nullptr;
+std::unordered_map<std::uint32_t, unsigned int> ResourceManager::shaderHandles;
+std::unordered_map<std::uint32_t, unsigned int> ResourceManager::textureHandles;
+std::vector<std::string>                        ResourceManager::shaderNames;
+std::vector<std::string>                        ResourceManager::textureNames;
 
 
-Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
+Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, ResourceId name, const char* defines)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-    return Shaders[name];
+    return Shaders[storeShader(name, loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile, defines))];
 }
 
-Shader ResourceManager::GetShader(std::string name)
+Shader ResourceManager::LoadTransformFeedbackShader(const char* vShaderFile, const char* const* varyings, int count, ResourceId name)
 {
-    return Shaders[name];
+    std::string vertexCode;
+    try
+    {
+        std::ifstream vertexShaderFile(vShaderFile);
+        std::stringstream vShaderStream;
+        vShaderStream << vertexShaderFile.rdbuf();
+        vertexShaderFile.close();
+        vertexCode = vShaderStream.str();
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
+    }
+    Shader shader;
+    shader.CompileTransformFeedback(vertexCode.c_str(), varyings, count);
+    storeShader(name, shader);
+    return shader;
+}
+
+ShaderHandle ResourceManager::FindShader(ResourceId name)
+{
+    int handle = findHandle(shaderHandles, shaderNames, name);
+    if (handle >= 0)
+        return handle;
+    // reported once, from then on the name draws nothing
+    std::cout << "ERROR::RESOURCES: No shader named " << name.Name << std::endl;
+    Shader missing;
+    missing.ID = 0;
+    return storeShader(name, missing);
+}
+
+bool ResourceManager::HasShader(ResourceId name)
+{
+    return findHandle(shaderHandles, shaderNames, name) >= 0;
 }
 
-Texture2D ResourceManager::LoadTexture(const char* file, bool alpha, std::string name)
+Shader ResourceManager::GetShader(ShaderHandle handle)
 {
-    Textures[name] = loadTextureFromFile(file, alpha);
-    return Textures[name];
+    return Shaders[handle];
 }
 
-Texture2D ResourceManager::GetTexture(std::string name)
+Shader ResourceManager::GetShader(ResourceId name)
 {
-    return Textures[name];
+    return Shaders[FindShader(name)];
+}
+
+Texture2D ResourceManager::LoadTexture(const char* file, bool alpha, ResourceId name)
+{
+    return Textures[storeTexture(name, loadTextureFromFile(file, alpha))];
+}
+
+std::shared_future<Texture2D> ResourceManager::LoadTextureAsync(const char* file, bool alpha, ResourceId name, TextureLoader::Callback onReady)
+{
+    if (!loader)
+        loader = new TextureLoader();
+    // the texture stored under the name (an empty one at first) is drawn until the new one replaces it
+    int handle = findHandle(textureHandles, textureNames, name);
+    if (handle < 0)
+        handle = storeTexture(name, Texture2D());
+    return loader->Load(file, alpha, [handle, onReady](const Texture2D& texture) {
+        Textures[handle] = texture;
+        if (onReady)
+            onReady(texture);
+    }, Textures[handle]);
+}
+
+void ResourceManager::UpdateTextures(float budget)
+{
+    if (loader)
+        loader->Update(budget);
+}
+
+void ResourceManager::FinishTextures()
+{
+    if (loader)
+        loader->Finish();
+}
+
+TextureHandle ResourceManager::FindTexture(ResourceId name)
+{
+    int handle = findHandle(textureHandles, textureNames, name);
+    if (handle >= 0)
+        return handle;
+    // reported once, from then on the name samples an empty texture
+    std::cout << "ERROR::RESOURCES: No texture named " << name.Name << std::endl;
+    return storeTexture(name, Texture2D());
+}
+
+Texture2D ResourceManager::GetTexture(TextureHandle handle)
+{
+    return Textures[handle];
+}
+
+Texture2D ResourceManager::GetTexture(ResourceId name)
+{
+    return Textures[FindTexture(name)];
 }
 
 void ResourceManager::LoadIconFromFile(const char* file, bool alpha, GLFWwindow *window)
@@ -52,15 +142,66 @@ void ResourceManager::LoadIconFromFile(const char* file, bool alpha, GLFWwindow
 
 void ResourceManager::Clear()
 {
+    // stop loading textures, the ones that aren't ready are deleted
+    delete loader;
+    loader = nullptr;
     // (properly) delete all shaders	
-    for (auto iter : Shaders)
-        glDeleteProgram(iter.second.ID);
+    for (const Shader& shader : Shaders)
+        glDeleteProgram(shader.ID);
     // (properly) delete all textures
-    for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
+    for (const Texture2D& texture : Textures)
+        glDeleteTextures(1, &texture.ID);
+    // the handles are gone with them
+    Shaders.clear();
+    Textures.clear();
+    shaderHandles.clear();
+    textureHandles.clear();
+    shaderNames.clear();
+    textureNames.clear();
+    // deleted objects were unbound by the context behind the state cache's back
+    StateCache::Invalidate();
+}
+
+ShaderHandle ResourceManager::storeShader(ResourceId name, const Shader& shader)
+{
+    int handle = findHandle(shaderHandles, shaderNames, name);
+    if (handle >= 0)
+    {
+        Shaders[handle] = shader;
+        return handle;
+    }
+    shaderHandles[name.Hash] = static_cast<unsigned int>(Shaders.size());
+    shaderNames.push_back(name.Name);
+    Shaders.push_back(shader);
+    return static_cast<ShaderHandle>(Shaders.size() - 1);
 }
 
-Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile)
+TextureHandle ResourceManager::storeTexture(ResourceId name, const Texture2D& texture)
+{
+    int handle = findHandle(textureHandles, textureNames, name);
+    if (handle >= 0)
+    {
+        Textures[handle] = texture;
+        return handle;
+    }
+    textureHandles[name.Hash] = static_cast<unsigned int>(Textures.size());
+    textureNames.push_back(name.Name);
+    Textures.push_back(texture);
+    return static_cast<TextureHandle>(Textures.size() - 1);
+}
+
+int ResourceManager::findHandle(const std::unordered_map<std::uint32_t, unsigned int>& handles, const std::vector<std::string>& names, ResourceId name)
+{
+    std::unordered_map<std::uint32_t, unsigned int>::const_iterator handle = handles.find(name.Hash);
+    if (handle == handles.end())
+        return -1;
+    // two names with the same hash would share their resources
+    if (names[handle->second] != name.Name)
+        std::cout << "ERROR::RESOURCES: " << names[handle->second] << " and " << name.Name << " have the same hash, rename one of them" << std::endl;
+    return static_cast<int>(handle->second);
+}
+
+Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, const char* defines)
 {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -91,10 +232,17 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
             geometryCode = gShaderStream.str();
         }
     }
-    catch (std::exception e)
+    catch (const std::exception& e)
     {
         std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
     }
+    if (defines != nullptr)
+    {
+        vertexCode = injectDefines(vertexCode, defines);
+        fragmentCode = injectDefines(fragmentCode, defines);
+        if (gShaderFile != nullptr)
+            geometryCode = injectDefines(geometryCode, defines);
+    }
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
     const char* gShaderCode = geometryCode.c_str();
@@ -104,10 +252,28 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
     return shader;
 }
 
+std::string ResourceManager::injectDefines(const std::string& source, const char* defines)
+{
+    // #version has to stay the first statement, so the definitions go on the line after it
+    std::size_t version = source.find("#version");
+    std::size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return defines + source;
+    std::string result(source, 0, lineEnd + 1);
+    result += defines;
+    result.append(source, lineEnd + 1, std::string::npos);
+    return result;
+}
+
 Texture2D ResourceManager::loadTextureFromFile(const char* file, bool alpha)
 {
     // create texture object
     Texture2D texture;
+    // prefer the block compressed version with mipmaps if it was converted (see CompressTextures)
+    std::string compressed(file);
+    compressed = compressed.substr(0, compressed.find_last_of('.')) + ".ktx";
+    if (LoadKtx(compressed.c_str(), texture))
+        return texture;
     if (alpha)
     {
         texture.Internal_Format = GL_RGBA;
@@ -9,35 +9,86 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
-#include <map>
+#include <cstdint>
+#include <future>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 
 #include "texture.h"
 #include "shader.h"
+#include "texture_loader.h"
 #include <GLFW/glfw3.h>
 
 
+// Names a resource by its string and the string's 32-bit FNV-1a hash.
+// Built from a string literal in a constant expression, the hash is
+// computed at compile time:
+//   constexpr ResourceId BACKGROUND("background");
+// Only the hash is looked up; the name is kept for error messages.
+struct ResourceId {
+    std::uint32_t Hash;
+    const char*   Name;
+    constexpr ResourceId(const char* name) : Hash(HashName(name)), Name(name) { }
+    ResourceId(const std::string& name) : ResourceId(name.c_str()) { }
+    static constexpr std::uint32_t HashName(const char* name)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (; *name; ++name)
+            hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+        return hash;
+    }
+};
+
+// index of a stored resource, resolved from its name once and valid until Clear
+typedef unsigned int ShaderHandle;
+typedef unsigned int TextureHandle;
+
+
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
-// public constructor is defined.
+// and/or shader is also stored for future reference by name. A
+// name is resolved into a handle once (FindShader/FindTexture),
+// after which retrieving the resource is a plain array index;
+// code running every frame keeps handles rather than names.
+// All functions and resources are static and no public
+// constructor is defined.
 class ResourceManager
 {
 public:
-    // resource storage
-    static std::map<std::string, Shader>    Shaders;
-    static std::map<std::string, Texture2D> Textures;
-    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader    LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
+    // resource storage, indexed by handle
+    static std::vector<Shader>    Shaders;
+    static std::vector<Texture2D> Textures;
+    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader.
+    // If defines is not nullptr, it's inserted after the #version line of every stage (e.g. "#define SHAKE\n") to compile a permutation of the shader
+    static Shader    LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, ResourceId name, const char* defines = nullptr);
+    // loads (and generates) a vertex-only transform feedback program from file, capturing the given varyings
+    static Shader    LoadTransformFeedbackShader(const char* vShaderFile, const char* const* varyings, int count, ResourceId name);
+    // returns the handle of a shader; a name nothing was loaded under is reported and stored as an empty program
+    static ShaderHandle FindShader(ResourceId name);
+    // returns true if a shader is stored under name
+    static bool      HasShader(ResourceId name);
     // retrieves a stored sader
-    static Shader    GetShader(std::string name);
+    static Shader    GetShader(ShaderHandle handle);
+    static Shader    GetShader(ResourceId name);
     // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char* file, bool alpha, std::string name);
+    static Texture2D LoadTexture(const char* file, bool alpha, ResourceId name);
+    // starts loading a texture in the background (see TextureLoader). Its handle is valid right away and keeps
+    // the texture stored under the name before (or an empty one) until the new one is ready; it's then stored
+    // under the handle right before onReady is called and the old one deleted, so keep handles rather than
+    // copies of the texture. If the file fails to load the old texture stays and onReady isn't called
+    static std::shared_future<Texture2D> LoadTextureAsync(const char* file, bool alpha, ResourceId name, TextureLoader::Callback onReady = nullptr);
+    // uploads the textures loading in the background for at most budget milliseconds, call it once a frame
+    static void UpdateTextures(float budget);
+    // blocks until all textures loading in the background are stored
+    static void FinishTextures();
+    // returns the handle of a texture; a name nothing was loaded under is reported and stored as an empty texture
+    static TextureHandle FindTexture(ResourceId name);
     // retrieves a stored texture
-    static Texture2D GetTexture(std::string name);
+    static Texture2D GetTexture(TextureHandle handle);
+    static Texture2D GetTexture(ResourceId name);
     // loads icon from file
     static void LoadIconFromFile(const char* file, bool alpha, GLFWwindow* window);
     // properly de-allocates all loaded resources
@@ -45,9 +96,21 @@ public:
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
+    // loads the textures of LoadTextureAsync, created with the first one
+    static TextureLoader* loader;
+    // handles by name hash, and the names for reporting hash collisions
+    static std::unordered_map<std::uint32_t, unsigned int> shaderHandles, textureHandles;
+    static std::vector<std::string>                        shaderNames, textureNames;
+    // stores a resource under name, replacing the one stored under it before; returns its handle
+    static ShaderHandle  storeShader(ResourceId name, const Shader& shader);
+    static TextureHandle storeTexture(ResourceId name, const Texture2D& texture);
+    // returns the handle stored under name in handles, or -1 if there's none; reports names colliding with it
+    static int findHandle(const std::unordered_map<std::uint32_t, unsigned int>& handles, const std::vector<std::string>& names, ResourceId name);
     // loads and generates a shader from file
-    static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr);
-    // loads a single texture from file
+    static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr, const char* defines = nullptr);
+    // inserts preprocessor definitions right after the #version line of a shader's source
+    static std::string injectDefines(const std::string& source, const char* defines);
+    // loads a single texture from file, or from the KTX file next to it if there is one the context supports
     static Texture2D loadTextureFromFile(const char* file, bool alpha);
 };
 
@@ -7,17 +7,27 @@
 ** option) any later version.
 ******************************************************************/
 #include "shader.h"
+#include "state_cache.h"
+#include "program_cache.h"
 
 #include <iostream>
 
 Shader& Shader::Use()
 {
-    glUseProgram(this->ID);
+    StateCache::UseProgram(this->ID);
     return *this;
 }
 
 void Shader::Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
 {
+    // the binary of the same program from an earlier run skips compiling and linking
+    std::uint64_t key = ProgramCache::Key({ vertexSource, fragmentSource, geometrySource });
+    this->ID = ProgramCache::Load(key);
+    if (this->ID != 0)
+    {
+        this->introspectUniforms();
+        return;
+    }
     unsigned int sVertex, sFragment, gShader;
     // vertex Shader
     sVertex = glCreateShader(GL_VERTEX_SHADER);
@@ -43,8 +53,11 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
     glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
+    ProgramCache::Prepare(this->ID);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    ProgramCache::Store(this->ID, key);
+    this->introspectUniforms();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
@@ -52,59 +65,123 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
         glDeleteShader(gShader);
 }
 
+void Shader::CompileTransformFeedback(const char* vertexSource, const char* const* varyings, int count)
+{
+    // the captured varyings are part of the program, so they're part of its key as well
+    std::vector<const char*> parts = { "transform feedback", vertexSource };
+    parts.insert(parts.end(), varyings, varyings + count);
+    std::uint64_t key = ProgramCache::Key(parts);
+    this->ID = ProgramCache::Load(key);
+    if (this->ID != 0)
+    {
+        this->introspectUniforms();
+        return;
+    }
+    unsigned int sVertex;
+    // vertex Shader
+    sVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(sVertex, 1, &vertexSource, NULL);
+    glCompileShader(sVertex);
+    checkCompileErrors(sVertex, "VERTEX");
+    // shader program; the captured varyings have to be declared before linking
+    this->ID = glCreateProgram();
+    glAttachShader(this->ID, sVertex);
+    glTransformFeedbackVaryings(this->ID, count, varyings, GL_INTERLEAVED_ATTRIBS);
+    ProgramCache::Prepare(this->ID);
+    glLinkProgram(this->ID);
+    checkCompileErrors(this->ID, "PROGRAM");
+    ProgramCache::Store(this->ID, key);
+    this->introspectUniforms();
+    glDeleteShader(sVertex);
+}
+
 void Shader::SetFloat(const char* name, float value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    this->Set(this->GetUniform<float>(name), value, useShader);
 }
 void Shader::SetInteger(const char* name, int value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    this->Set(this->GetUniform<int>(name), value, useShader);
 }
 void Shader::SetVector2f(const char* name, float x, float y, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    this->Set(this->GetUniform<glm::vec2>(name), glm::vec2(x, y), useShader);
 }
 void Shader::SetVector2f(const char* name, const glm::vec2& value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    this->Set(this->GetUniform<glm::vec2>(name), value, useShader);
 }
 void Shader::SetVector3f(const char* name, float x, float y, float z, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    this->Set(this->GetUniform<glm::vec3>(name), glm::vec3(x, y, z), useShader);
 }
 void Shader::SetVector3f(const char* name, const glm::vec3& value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    this->Set(this->GetUniform<glm::vec3>(name), value, useShader);
 }
 void Shader::SetVector4f(const char* name, float x, float y, float z, float w, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    this->Set(this->GetUniform<glm::vec4>(name), glm::vec4(x, y, z, w), useShader);
 }
 void Shader::SetVector4f(const char* name, const glm::vec4& value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    this->Set(this->GetUniform<glm::vec4>(name), value, useShader);
 }
 void Shader::SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    this->Set(this->GetUniform<glm::mat4>(name), matrix, useShader);
+}
+
+void Shader::introspectUniforms()
+{
+    this->uniforms = std::make_shared<UniformCache>();
+    int count = 0, maxLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(maxLength + 1);
+    for (int i = 0; i < count; ++i)
+    {
+        int size, length;
+        GLenum type;
+        glGetActiveUniform(this->ID, i, maxLength + 1, &length, &size, &type, name.data());
+        int location = glGetUniformLocation(this->ID, name.data());
+        if (location < 0) // uniform block members have no location
+            continue;
+        int slot = static_cast<int>(this->uniforms->Locations.size());
+        this->uniforms->Locations.push_back(location);
+        this->uniforms->Values.push_back({});
+        this->uniforms->Valid.push_back(false);
+        std::string uniformName(name.data(), length);
+        this->uniforms->Slots[uniformName] = slot;
+        // arrays are reported as "name[0]"; also make them accessible by their plain name
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            this->uniforms->Slots[uniformName.substr(0, uniformName.size() - 3)] = slot;
+    }
+}
+
+void Shader::uploadUniform(int location, float value)
+{
+    glUniform1f(location, value);
+}
+void Shader::uploadUniform(int location, int value)
+{
+    glUniform1i(location, value);
+}
+void Shader::uploadUniform(int location, const glm::vec2& value)
+{
+    glUniform2f(location, value.x, value.y);
+}
+void Shader::uploadUniform(int location, const glm::vec3& value)
+{
+    glUniform3f(location, value.x, value.y, value.z);
+}
+void Shader::uploadUniform(int location, const glm::vec4& value)
+{
+    glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+void Shader::uploadUniform(int location, const glm::mat4& value)
+{
+    glUniformMatrix4fv(location, 1, false, glm::value_ptr(value));
 }
 
 
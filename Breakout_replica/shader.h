@@ -1,12 +1,28 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <array>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Typed handle to a uniform of a linked shader program. Handles are
+// resolved once through Shader::GetUniform and index the program's
+// shadow of current uniform values, so setting a uniform through a
+// handle needs no name lookup and skips redundant uploads.
+template <typename T>
+struct Uniform
+{
+    int Location = -1; // -1 if the uniform is not active in the program
+    int Slot = -1;     // index into the program's value shadow
+};
+
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
 // functions for easy management.
@@ -21,6 +37,14 @@ public:
     Shader& Use();
     // compiles the shader from given source code
     void    Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr); // note: geometry source code is optional 
+    // compiles a vertex-only program whose outputs are captured (interleaved) with transform feedback
+    void    CompileTransformFeedback(const char* vertexSource, const char* const* varyings, int count);
+    // retrieves a typed handle to an active uniform; resolve once and keep it
+    template <typename T>
+    Uniform<T> GetUniform(const char* name) const;
+    // sets a uniform through its handle; nothing is uploaded if the value didn't change (the program is still bound if useShader is set)
+    template <typename T>
+    void    Set(Uniform<T> uniform, const T& value, bool useShader = false);
     // utility functions
     void    SetFloat(const char* name, float value, bool useShader = false);
     void    SetInteger(const char* name, int value, bool useShader = false);
@@ -32,9 +56,59 @@ public:
     void    SetVector4f(const char* name, const glm::vec4& value, bool useShader = false);
     void    SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
 private:
+    // active uniforms as introspected at link time together with a shadow
+    // of their last uploaded values; shared by all copies of the program
+    struct UniformCache
+    {
+        std::unordered_map<std::string, int>      Slots;
+        std::vector<int>                          Locations;
+        std::vector<std::array<unsigned char, 64>> Values; // raw bytes of the last uploaded value (mat4 at most)
+        std::vector<bool>                         Valid;
+    };
+    std::shared_ptr<UniformCache> uniforms;
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type);
+    // queries all active uniforms of the linked program and resets the value shadow
+    void    introspectUniforms();
+    // uploads a value to the uniform at the given location of the current program
+    static void uploadUniform(int location, float value);
+    static void uploadUniform(int location, int value);
+    static void uploadUniform(int location, const glm::vec2& value);
+    static void uploadUniform(int location, const glm::vec3& value);
+    static void uploadUniform(int location, const glm::vec4& value);
+    static void uploadUniform(int location, const glm::mat4& value);
 };
 
+template <typename T>
+Uniform<T> Shader::GetUniform(const char* name) const
+{
+    Uniform<T> uniform;
+    if (!this->uniforms)
+        return uniform;
+    auto it = this->uniforms->Slots.find(name);
+    if (it != this->uniforms->Slots.end())
+    {
+        uniform.Slot = it->second;
+        uniform.Location = this->uniforms->Locations[it->second];
+    }
+    return uniform;
+}
+
+template <typename T>
+void Shader::Set(Uniform<T> uniform, const T& value, bool useShader)
+{
+    static_assert(sizeof(T) <= 64, "uniform value does not fit the shadow");
+    if (useShader)
+        this->Use();
+    if (uniform.Slot < 0)
+        return;
+    unsigned char* shadow = this->uniforms->Values[uniform.Slot].data();
+    if (this->uniforms->Valid[uniform.Slot] && std::memcmp(shadow, &value, sizeof(T)) == 0)
+        return;
+    std::memcpy(shadow, &value, sizeof(T));
+    this->uniforms->Valid[uniform.Slot] = true;
+    uploadUniform(uniform.Location, value);
+}
+
 
 #endif // !SHADER_H
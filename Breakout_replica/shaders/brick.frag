@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 TexCoords;
+in vec3 BrickColor;
+out vec4 color;
+
+uniform sampler2DArray layers;
+
+void main()
+{    
+    color = vec4(BrickColor, 1.0) * texture(layers, TexCoords);
+}
\ No newline at end of file
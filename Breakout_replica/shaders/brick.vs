@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec4 vertex;   // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 brick;    // <vec2 position, vec2 size> (per instance)
+layout (location = 2) in uint material; // index into the material table (per instance)
+layout (location = 3) in float alive;   // (per instance)
+
+out vec3 TexCoords; // <vec2 texCoords, layer>
+out vec3 BrickColor;
+
+// <vec3 color, layer> per material, filled by the MaterialLibrary
+layout (std140) uniform Materials
+{
+    vec4 materials[MAX_MATERIALS];
+};
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = vec3(vertex.zw, materials[material].w);
+    BrickColor = materials[material].rgb;
+    // destroyed bricks collapse into a degenerate quad so they never reach the rasterizer
+    gl_Position = projection * vec4(brick.xy + vertex.xy * brick.zw * alive, 0.0, 1.0);
+}
\ No newline at end of file
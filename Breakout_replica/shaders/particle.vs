@@ -1,16 +1,18 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 0) in vec4  vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec2  offset; // (per instance)
+layout (location = 2) in vec4  color;  // (per instance)
+layout (location = 3) in float life;   // (per instance)
 
 out vec2 TexCoords;
 out vec4 ParticleColor;
 
 uniform mat4 projection;
-uniform vec2 offset;
-uniform vec4 color;
 
 void main()
 {
-    float scale = 10.0f;
+    // dead particles collapse into a degenerate quad
+    float scale = life > 0.0 ? 10.0f : 0.0f;
     TexCoords = vertex.zw;
     ParticleColor = color;
     gl_Position = projection * vec4((vertex.xy * scale) + offset, 0.0, 1.0);
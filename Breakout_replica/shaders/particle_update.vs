@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec2  position;
+layout (location = 1) in vec2  velocity;
+layout (location = 2) in vec4  color;
+layout (location = 3) in float life;
+
+// captured with transform feedback in the same layout as the input
+out vec2  outPosition;
+out vec2  outVelocity;
+out vec4  outColor;
+out float outLife;
+
+uniform float dt;
+
+void main()
+{
+    outLife = life - dt; // reduce life
+    outVelocity = velocity;
+    outPosition = position;
+    outColor = color;
+    if (outLife > 0.0)
+    {   // particle is alive, thus update
+        outPosition -= velocity * dt;
+        outColor.a -= dt * 2.5;
+    }
+}
\ No newline at end of file
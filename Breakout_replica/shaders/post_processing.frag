@@ -3,42 +3,32 @@ in  vec2  TexCoords;
 out vec4  color;
   
 uniform sampler2D scene;
-uniform vec2      offsets[9];
-uniform int       edge_kernel[9];
-uniform float     blur_kernel[9];
 
-uniform bool chaos;
-uniform bool confuse;
-uniform bool shake;
+// the enabled effects are #defined (CHAOS, CONFUSE, SHAKE) right after the #version line,
+// their kernels are folded into constant weights below
+const float offset = 1.0 / 300.0;
 
-void main()
+vec3 tap(float x, float y)
 {
-    color = vec4(0.0f);
-    vec3 sample[9];
-    // sample from texture offsets if using convolution matrix
-    if(chaos || shake)
-        for(int i = 0; i < 9; i++)
-            sample[i] = vec3(texture(scene, TexCoords.st + offsets[i]));
-
-    // process effects
-    if (chaos)
-    {           
-        for(int i = 0; i < 9; i++)
-            color += vec4(sample[i] * edge_kernel[i], 0.0f);
-        color.a = 1.0f;
-    }
-    else if (confuse)
-    {
-        color = vec4(1.0 - texture(scene, TexCoords).rgb, 1.0);
-    }
-    else if (shake)
-    {
-        for(int i = 0; i < 9; i++)
-            color += vec4(sample[i] * blur_kernel[i], 0.0f);
-        color.a = 1.0f;
-    }
-    else
-    {
-        color =  texture(scene, TexCoords);
-    }
+    return texture(scene, TexCoords.st + vec2(x, y) * offset).rgb;
 }
+
+void main()
+{
+#if defined(CHAOS)
+    // edge detection: 8 times the center minus its 8 neighbours
+    vec3 neighbours = tap(-1.0,  1.0) + tap(0.0,  1.0) + tap(1.0,  1.0)
+                    + tap(-1.0,  0.0)                  + tap(1.0,  0.0)
+                    + tap(-1.0, -1.0) + tap(0.0, -1.0) + tap(1.0, -1.0);
+    color = vec4(8.0 * tap(0.0, 0.0) - neighbours, 1.0);
+#elif defined(CONFUSE)
+    color = vec4(1.0 - texture(scene, TexCoords).rgb, 1.0);
+#elif defined(SHAKE)
+    // 3x3 gaussian blur with weights 1 (corners), 2 (edges) and 4 (center) out of 16
+    vec3 corners = tap(-1.0,  1.0) + tap(1.0,  1.0) + tap(-1.0, -1.0) + tap(1.0, -1.0);
+    vec3 edges   = tap( 0.0,  1.0) + tap(-1.0, 0.0) + tap( 1.0,  0.0) + tap(0.0, -1.0);
+    color = vec4((corners + 2.0 * edges + 4.0 * tap(0.0, 0.0)) / 16.0, 1.0);
+#else
+    color = texture(scene, TexCoords);
+#endif
+}
\ No newline at end of file
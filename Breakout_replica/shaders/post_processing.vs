@@ -3,33 +3,24 @@ layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
 
 out vec2 TexCoords;
 
-uniform bool  chaos;
-uniform bool  confuse;
-uniform bool  shake;
+// the enabled effects are #defined (CHAOS, CONFUSE, SHAKE) right after the #version line
 uniform float time;
 
 void main()
 {
     gl_Position = vec4(vertex.xy, 0.0f, 1.0f); 
     vec2 texture = vertex.zw;
-    if (chaos)
-    {
-        float strength = 0.1;
-        vec2 pos = vec2(texture.x + sin(time) * strength, texture.y + cos(time) * strength);        
-        TexCoords = pos;
-    }
-    else if (confuse)
-    {
-        TexCoords = vec2(1.0 - texture.x, 1.0 - texture.y);
-    }
-    else
-    {
-        TexCoords = texture;
-    }
-    if (shake)
-    {
-        float strength = 0.01;
-        gl_Position.x += cos(time * 10) * strength;        
-        gl_Position.y += cos(time * 15) * strength;        
-    }
+#if defined(CHAOS)
+    float strength = 0.1;
+    TexCoords = vec2(texture.x + sin(time) * strength, texture.y + cos(time) * strength);
+#elif defined(CONFUSE)
+    TexCoords = vec2(1.0 - texture.x, 1.0 - texture.y);
+#else
+    TexCoords = texture;
+#endif
+#if defined(SHAKE)
+    float shakeStrength = 0.01;
+    gl_Position.x += cos(time * 10) * shakeStrength;        
+    gl_Position.y += cos(time * 15) * shakeStrength;        
+#endif
 }  
\ No newline at end of file
@@ -1,12 +1,28 @@
 #version 330 core
-in vec2 TexCoords;
+in vec3 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
-uniform sampler2D text;
-uniform vec3 textColor;
+uniform sampler2DArray text;
+// widths are in distance field units, the glyph edge lies at 0.5
+uniform vec4 outlineColor;
+uniform float outlineWidth;
+uniform vec4 glowColor;
+uniform float glowWidth;
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    float dist = texture(text, TexCoords).r;
+    // anti-alias across roughly one screen pixel, whatever the text is scaled to
+    float smoothing = max(fwidth(dist) * 0.5, 0.001);
+    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);
+    float outline = smoothstep(0.5 - outlineWidth - smoothing, 0.5 - outlineWidth + smoothing, dist) * outlineColor.a;
+    float alpha = max(fill, outline);
+    vec3 rgb = mix(outlineColor.rgb, TextColor, fill / max(alpha, 0.001));
+    // composite the glow behind the glyph
+    float glow = 0.0;
+    if (glowWidth > 0.0)
+        glow = smoothstep(0.5 - glowWidth, 0.5, dist) * glowColor.a;
+    float outAlpha = alpha + glow * (1.0 - alpha);
+    color = vec4((rgb * alpha + glowColor.rgb * glow * (1.0 - alpha)) / max(outAlpha, 0.001), outAlpha);
 }  
\ No newline at end of file
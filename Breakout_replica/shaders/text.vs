@@ -1,11 +1,15 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
-out vec2 TexCoords;
+layout (location = 1) in vec3 color;
+layout (location = 2) in float page;
+out vec3 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
 
 void main()
 {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-    TexCoords = vertex.zw;
-} 
\ No newline at end of file
+    TexCoords = vec3(vertex.zw, page);
+    TextColor = color;
+}
\ No newline at end of file
@@ -7,17 +7,22 @@
 ** option) any later version.
 ******************************************************************/
 #include "sprite_renderer.h"
+#include "state_cache.h"
 
 
 SpriteRenderer::SpriteRenderer(Shader& shader)
 {
     this->shader = shader;
+    this->modelUniform = this->shader.GetUniform<glm::mat4>("model");
+    this->colorUniform = this->shader.GetUniform<glm::vec3>("spriteColor");
     this->initRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer()
 {
     glDeleteVertexArrays(1, &this->quadVAO);
+    // the deleted vertex array was unbound behind the state cache's back, a new one may reuse its name
+    StateCache::Invalidate();
 }
 
 void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
@@ -33,17 +38,16 @@ void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec
 
     model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
 
-    this->shader.SetMatrix4("model", model);
+    this->shader.Set(this->modelUniform, model);
 
     // render textured quad
-    this->shader.SetVector3f("spriteColor", color);
+    this->shader.Set(this->colorUniform, color);
 
-    glActiveTexture(GL_TEXTURE0);
+    StateCache::ActiveTexture(GL_TEXTURE0);
     texture.Bind();
 
-    glBindVertexArray(this->quadVAO);
+    StateCache::BindVertexArray(this->quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 }
 
 void SpriteRenderer::initRenderData()
@@ -67,9 +71,9 @@ void SpriteRenderer::initRenderData()
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->quadVAO);
+    StateCache::BindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    StateCache::BindVertexArray(0);
 }
\ No newline at end of file
@@ -29,6 +29,8 @@ public:
 private:
     // Render state
     Shader       shader;
+    Uniform<glm::mat4> modelUniform;
+    Uniform<glm::vec3> colorUniform;
     unsigned int quadVAO;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData();
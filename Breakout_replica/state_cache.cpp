@@ -0,0 +1,142 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "state_cache.h"
+
+// value that never matches a real object/enum, so the next call is always issued
+static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+// Instantiate static variables
+StateCache::Stats StateCache::LastFrame = { 0, 0 };
+StateCache::Stats StateCache::current = { 0, 0 };
+unsigned int      StateCache::program = UNKNOWN;
+unsigned int      StateCache::vertexArray = UNKNOWN;
+unsigned int      StateCache::activeUnit = UNKNOWN;
+unsigned int      StateCache::textures[StateCache::MAX_TEXTURE_UNITS][StateCache::TARGET_COUNT];
+GLenum            StateCache::blendSrc = UNKNOWN;
+GLenum            StateCache::blendDst = UNKNOWN;
+unsigned int      StateCache::readFramebuffer = UNKNOWN;
+unsigned int      StateCache::drawFramebuffer = UNKNOWN;
+
+
+void StateCache::BeginFrame()
+{
+    LastFrame = current;
+    current.Issued = current.Dropped = 0;
+}
+
+void StateCache::Invalidate()
+{
+    program = vertexArray = activeUnit = UNKNOWN;
+    for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+        for (unsigned int target = 0; target < TARGET_COUNT; ++target)
+            textures[unit][target] = UNKNOWN;
+    blendSrc = blendDst = UNKNOWN;
+    readFramebuffer = drawFramebuffer = UNKNOWN;
+}
+
+void StateCache::UseProgram(unsigned int program)
+{
+    if (StateCache::program == program)
+    {
+        ++current.Dropped;
+        return;
+    }
+    StateCache::program = program;
+    glUseProgram(program);
+    ++current.Issued;
+}
+
+void StateCache::BindVertexArray(unsigned int vertexArray)
+{
+    if (StateCache::vertexArray == vertexArray)
+    {
+        ++current.Dropped;
+        return;
+    }
+    StateCache::vertexArray = vertexArray;
+    glBindVertexArray(vertexArray);
+    ++current.Issued;
+}
+
+void StateCache::ActiveTexture(GLenum unit)
+{
+    if (activeUnit == unit)
+    {
+        ++current.Dropped;
+        return;
+    }
+    activeUnit = unit;
+    glActiveTexture(unit);
+    ++current.Issued;
+}
+
+void StateCache::BindTexture(GLenum target, unsigned int texture)
+{
+    unsigned int unit = activeUnit - GL_TEXTURE0;
+    int slot = targetIndex(target);
+    // untracked unit or target: always forward the call and forget what we knew
+    if (activeUnit == UNKNOWN || unit >= MAX_TEXTURE_UNITS || slot < 0)
+    {
+        if (activeUnit != UNKNOWN && unit < MAX_TEXTURE_UNITS)
+            for (unsigned int i = 0; i < TARGET_COUNT; ++i)
+                textures[unit][i] = UNKNOWN;
+        glBindTexture(target, texture);
+        ++current.Issued;
+        return;
+    }
+    if (textures[unit][slot] == texture)
+    {
+        ++current.Dropped;
+        return;
+    }
+    textures[unit][slot] = texture;
+    glBindTexture(target, texture);
+    ++current.Issued;
+}
+
+void StateCache::BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (blendSrc == sfactor && blendDst == dfactor)
+    {
+        ++current.Dropped;
+        return;
+    }
+    blendSrc = sfactor;
+    blendDst = dfactor;
+    glBlendFunc(sfactor, dfactor);
+    ++current.Issued;
+}
+
+void StateCache::BindFramebuffer(GLenum target, unsigned int framebuffer)
+{
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    if ((!read || readFramebuffer == framebuffer) && (!draw || drawFramebuffer == framebuffer))
+    {
+        ++current.Dropped;
+        return;
+    }
+    if (read)
+        readFramebuffer = framebuffer;
+    if (draw)
+        drawFramebuffer = framebuffer;
+    glBindFramebuffer(target, framebuffer);
+    ++current.Issued;
+}
+
+int StateCache::targetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D:       return TARGET_2D;
+    case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+    case GL_TEXTURE_BUFFER:   return TARGET_BUFFER;
+    default:                  return -1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <glad/glad.h>
+
+
+// A static singleton StateCache class that shadows the OpenGL state
+// changed during rendering: the current program, vertex array, the
+// textures bound per texture unit, the blend function and the bound
+// framebuffers. Calls that wouldn't change anything are dropped. All
+// code binds these through the cache so the shadow stays in sync with
+// the context; call Invalidate() after touching this state directly.
+// All functions are static and no public constructor is defined.
+class StateCache
+{
+public:
+    // amount of state calls forwarded to and dropped before the driver
+    struct Stats
+    {
+        unsigned int Issued;
+        unsigned int Dropped;
+    };
+    // statistics of the last completed frame
+    static Stats LastFrame;
+    // marks the start of a new frame; moves the running counters into LastFrame
+    static void BeginFrame();
+    // forgets all shadowed state so the next call of each kind is issued
+    static void Invalidate();
+    // state setters mirroring their OpenGL counterparts
+    static void UseProgram(unsigned int program);
+    static void BindVertexArray(unsigned int vertexArray);
+    static void ActiveTexture(GLenum unit);
+    static void BindTexture(GLenum target, unsigned int texture);
+    static void BlendFunc(GLenum sfactor, GLenum dfactor);
+    static void BindFramebuffer(GLenum target, unsigned int framebuffer);
+private:
+    // private constructor, that is we do not want any actual state cache objects
+    StateCache() { }
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+    // texture targets shadowed per unit
+    enum TextureTarget { TARGET_2D, TARGET_2D_ARRAY, TARGET_BUFFER, TARGET_COUNT };
+    // shadowed state
+    static unsigned int program, vertexArray, activeUnit;
+    static unsigned int textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+    static GLenum       blendSrc, blendDst;
+    static unsigned int readFramebuffer, drawFramebuffer;
+    // running counters of the current frame
+    static Stats current;
+    // maps a texture target to its shadow slot
+    static int targetIndex(GLenum target);
+};
+
+#endif
\ No newline at end of file
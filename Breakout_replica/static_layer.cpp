@@ -0,0 +1,125 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "static_layer.h"
+#include "state_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+StaticLayer::StaticLayer(glm::vec2 size, unsigned int width, unsigned int height, unsigned int samples)
+    : Width(0), Height(0), position(0.0f), size(size), samples(samples)
+{
+    glGenFramebuffers(1, &this->Framebuffer);
+    glGenRenderbuffers(1, &this->RBO);
+    glGenFramebuffers(1, &this->resolveFBO);
+    this->view.Internal_Format = GL_RGB;
+    this->view.Image_Format = GL_RGB;
+    this->Texture = this->view.ID;
+    this->Resize(width, height);
+}
+
+StaticLayer::~StaticLayer()
+{
+    glDeleteFramebuffers(1, &this->Framebuffer);
+    glDeleteFramebuffers(1, &this->resolveFBO);
+    glDeleteRenderbuffers(1, &this->RBO);
+    glDeleteTextures(1, &this->Texture);
+    // deleted objects were unbound by the context behind the state cache's back
+    StateCache::Invalidate();
+}
+
+void StaticLayer::Resize(unsigned int width, unsigned int height)
+{
+    this->Width = width;
+    this->Height = height;
+    // multisampled storage the layer is drawn into
+    StateCache::BindFramebuffer(GL_FRAMEBUFFER, this->Framebuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, this->samples, GL_RGB, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::STATICLAYER: Failed to initialize MSFBO" << std::endl;
+    // resolved texture it's composited from
+    this->view.Generate(width, height, NULL);
+    StateCache::BindFramebuffer(GL_FRAMEBUFFER, this->resolveFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::STATICLAYER: Failed to initialize FBO" << std::endl;
+    StateCache::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    this->Invalidate();
+}
+
+bool StaticLayer::SetView(glm::vec2 position, glm::vec2 size)
+{
+    if (position == this->position && size == this->size)
+        return false;
+    this->position = position;
+    this->size = size;
+    this->Invalidate();
+    return true;
+}
+
+void StaticLayer::Invalidate()
+{
+    this->dirty.assign(1, glm::ivec4(0, 0, this->Width, this->Height));
+}
+
+void StaticLayer::Invalidate(glm::vec2 position, glm::vec2 size)
+{
+    // whole pixels covering the area plus one around it for the multisampled edges, flipped to y pointing up
+    glm::vec2 scale = glm::vec2(this->Width, this->Height) / this->size;
+    glm::vec2 min = (position - this->position) * scale, max = (position + size - this->position) * scale;
+    int width = static_cast<int>(this->Width), height = static_cast<int>(this->Height);
+    int left = std::max(static_cast<int>(std::floor(min.x)) - 1, 0);
+    int right = std::min(static_cast<int>(std::ceil(max.x)) + 1, width);
+    int bottom = std::max(height - static_cast<int>(std::ceil(max.y)) - 1, 0);
+    int top = std::min(height - static_cast<int>(std::floor(min.y)) + 1, height);
+    if (left >= right || bottom >= top)
+        return;
+    if (this->dirty.size() == 1 && this->dirty[0] == glm::ivec4(0, 0, width, height))
+        return; // everything is redrawn already
+    if (this->dirty.size() == MAX_DIRTY_RECTS)
+    {
+        this->Invalidate();
+        return;
+    }
+    this->dirty.push_back(glm::ivec4(left, bottom, right - left, top - bottom));
+}
+
+bool StaticLayer::Dirty() const
+{
+    return !this->dirty.empty();
+}
+
+void StaticLayer::Update(const std::function<void()>& draw)
+{
+    glEnable(GL_SCISSOR_TEST);
+    for (const glm::ivec4& rect : this->dirty)
+    {
+        glScissor(rect.x, rect.y, rect.z, rect.w);
+        StateCache::BindFramebuffer(GL_FRAMEBUFFER, this->Framebuffer);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        draw();
+        // the scissor applies to the blit as well, so only the redrawn area is resolved
+        StateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, this->Framebuffer);
+        StateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, this->resolveFBO);
+        glBlitFramebuffer(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w, rect.x, rect.y, rect.x + rect.z, rect.y + rect.w, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    this->dirty.clear();
+}
+
+void StaticLayer::Submit(RenderQueue& queue, unsigned int layer)
+{
+    // the texture's rows start at the bottom, so the quad is flipped vertically
+    queue.Submit(layer, this->view, this->position + glm::vec2(0.0f, this->size.y), glm::vec2(this->size.x, -this->size.y));
+}
\ No newline at end of file
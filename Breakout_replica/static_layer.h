@@ -0,0 +1,73 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STATIC_LAYER_H
+#define STATIC_LAYER_H
+
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "render_queue.h"
+
+
+// StaticLayer retains the part of the scene that rarely changes (the
+// background and the bricks) in a render target of its own, so a frame
+// only has to copy it instead of drawing it again. Areas are marked dirty
+// when their contents change; Update() then draws the layer again
+// clipped to each dirty rectangle only. The layer is drawn multisampled
+// and resolved into Texture after every update, so compositing it is a
+// single textured quad. The layer covers the camera's view of the world
+// at whatever resolution the scene is rendered at; moving the view
+// invalidates all of it. A view that moves every frame (the camera
+// following the ball through a level wider than the screen) would redraw
+// the whole layer every frame only to copy it once, so while the view
+// moves the caller draws the contents straight into the scene instead and
+// the layer is redrawn once the view holds still again.
+class StaticLayer
+{
+public:
+    // multisampled framebuffer the layer is drawn into
+    unsigned int Framebuffer;
+    // resolved contents of the layer
+    unsigned int Texture;
+    // size of the layer's storage in pixels
+    unsigned int Width, Height;
+    // constructor/destructor, size is the area covered in world units
+    StaticLayer(glm::vec2 size, unsigned int width, unsigned int height, unsigned int samples);
+    ~StaticLayer();
+    // reallocates the layer's storage at a new resolution, marking it all dirty
+    void Resize(unsigned int width, unsigned int height);
+    // moves the area of the world covered by the layer, marking it all dirty if it changed;
+    // returns true if it did, in which case the layer shouldn't be updated or used this frame
+    bool SetView(glm::vec2 position, glm::vec2 size);
+    // marks the whole layer dirty
+    void Invalidate();
+    // marks an area (in world units, y pointing down) dirty
+    void Invalidate(glm::vec2 position, glm::vec2 size);
+    // returns true if any area has to be drawn again
+    bool Dirty() const;
+    // draws the dirty areas again by calling draw once per area with the layer's framebuffer
+    // bound and a scissor set, then resolves them into Texture
+    void Update(const std::function<void()>& draw);
+    // queues copying the layer over its view of the world into a layer of a render queue
+    void Submit(RenderQueue& queue, unsigned int layer);
+private:
+    // dirty areas are merged into the whole layer beyond this many
+    static const unsigned int MAX_DIRTY_RECTS = 8;
+    glm::vec2               position, size; // view of the world
+    unsigned int            samples;
+    unsigned int            RBO, resolveFBO;
+    Texture2D               view; // Texture wrapped for the sprite renderer
+    std::vector<glm::ivec4> dirty; // <x, y, width, height> in framebuffer pixels, y pointing up
+};
+
+#endif
\ No newline at end of file
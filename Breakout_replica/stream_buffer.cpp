@@ -0,0 +1,166 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "stream_buffer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+
+// ARB_buffer_storage (core in OpenGL 4.4) isn't part of the loaded OpenGL 3.3 functions
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// returns glBufferStorage if the context supports it
+static PFNGLBUFFERSTORAGEPROC loadBufferStorage()
+{
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 4);
+    int extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (int i = 0; i < extensionCount && !supported; ++i)
+        supported = std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_buffer_storage") == 0;
+    return supported ? (PFNGLBUFFERSTORAGEPROC)StreamBuffer::GetProcAddress("glBufferStorage") : nullptr;
+}
+
+GLADloadproc StreamBuffer::GetProcAddress = (GLADloadproc)glfwGetProcAddress;
+
+
+StreamBuffer::StreamBuffer(GLenum target, std::size_t regionSize)
+    : target(target), regionSize(regionSize), region(0), cursor(0), reserved(0), mapped(nullptr), reserving(false), fences()
+{
+    static PFNGLBUFFERSTORAGEPROC bufferStorage = loadBufferStorage();
+    std::size_t size = REGION_COUNT * regionSize;
+    glGenBuffers(1, &this->ID);
+    glBindBuffer(target, this->ID);
+    if (bufferStorage)
+    {
+        // immutable storage that stays mapped (and coherent) for the buffer's whole life
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(target, size, NULL, flags);
+        this->mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, size, flags));
+        if (!this->mapped)
+            std::cout << "ERROR::STREAMBUFFER: Failed to map buffer storage persistently" << std::endl;
+    }
+    else
+        glBufferData(target, size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(target, 0);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence : this->fences)
+        if (fence)
+            glDeleteSync(fence);
+    if (this->mapped)
+    {
+        glBindBuffer(this->target, this->ID);
+        glUnmapBuffer(this->target);
+        glBindBuffer(this->target, 0);
+    }
+    glDeleteBuffers(1, &this->ID);
+}
+
+void* StreamBuffer::Reserve(std::size_t size, std::size_t alignment)
+{
+    if (size > this->regionSize)
+        return nullptr;
+    std::size_t offset = (this->cursor + alignment - 1) / alignment * alignment;
+    if (offset + size > (this->region + 1) * this->regionSize)
+    {
+        // the frame wrote more than a region
+        this->nextRegion();
+        offset = this->cursor;
+    }
+    this->reserved = offset;
+    this->reserving = true;
+    if (this->mapped)
+        return this->mapped + offset;
+    // nothing the GPU may still read overlaps the range, so there's no need to synchronize
+    glBindBuffer(this->target, this->ID);
+    void* data = glMapBufferRange(this->target, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+    glBindBuffer(this->target, 0);
+    return data;
+}
+
+std::size_t StreamBuffer::Available(std::size_t alignment) const
+{
+    std::size_t offset = (this->cursor + alignment - 1) / alignment * alignment, end = (this->region + 1) * this->regionSize;
+    return offset < end ? end - offset : 0;
+}
+
+std::size_t StreamBuffer::Commit(std::size_t size)
+{
+    if (!this->reserving)
+        return this->reserved;
+    this->reserving = false;
+    if (!this->mapped)
+    {
+        glBindBuffer(this->target, this->ID);
+        if (size > 0)
+            glFlushMappedBufferRange(this->target, 0, size);
+        glUnmapBuffer(this->target);
+        glBindBuffer(this->target, 0);
+    }
+    this->cursor = this->reserved + size;
+    return this->reserved;
+}
+
+void StreamBuffer::EndFrame()
+{
+    this->nextRegion();
+}
+
+void StreamBuffer::nextRegion()
+{
+    if (this->reserving)
+        this->Commit(0);
+    // the GPU reads the region until the commands issued so far have completed
+    if (this->mapped)
+    {
+        if (this->fences[this->region])
+            glDeleteSync(this->fences[this->region]);
+        this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    this->region = (this->region + 1) % REGION_COUNT;
+    this->cursor = this->region * this->regionSize;
+    if (this->mapped)
+    {
+        // wait until the GPU is done with the region's previous contents (it normally already is)
+        GLsync fence = this->fences[this->region];
+        if (fence)
+        {
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+            glDeleteSync(fence);
+            this->fences[this->region] = nullptr;
+        }
+    }
+    else if (this->region == 0)
+    {
+        // the ring wrapped, orphan the storage instead of waiting for the GPU to release it
+        glBindBuffer(this->target, this->ID);
+        glBufferData(this->target, REGION_COUNT * this->regionSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(this->target, 0);
+    }
+}
+
+bool StreamBuffer::Persistent() const
+{
+    return this->mapped != nullptr;
+}
\ No newline at end of file
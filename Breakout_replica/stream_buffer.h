@@ -0,0 +1,66 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+
+// StreamBuffer hands out write-only memory for data that changes every
+// frame (dynamic vertices and the like). The buffer is split into
+// REGION_COUNT regions, one per frame, that are used round-robin: a
+// frame's data is written into the current region while the GPU still
+// reads the ones of the previous frames, and a fence guards every region
+// so it's never overwritten before the GPU is done with it. Any number of
+// reservations are carved out of a frame's region; EndFrame fences it and
+// moves on, so the CPU only waits if the GPU falls REGION_COUNT frames
+// behind. A frame writing more than a region continues in the next one
+// early, which may wait. With ARB_buffer_storage the buffer is mapped
+// once, persistently; on plain OpenGL 3.3 each reservation is mapped
+// unsynchronized and the buffer is orphaned whenever the ring wraps.
+class StreamBuffer
+{
+public:
+    // amount of regions the buffer is split into
+    static const unsigned int REGION_COUNT = 3;
+    // loads glBufferStorage, which glad's OpenGL 3.3 functions don't include; GLFW's loader
+    // unless the context wasn't created through GLFW (set it before creating buffers)
+    static GLADloadproc GetProcAddress;
+    // buffer object, bind it to source the committed data
+    unsigned int ID;
+    // constructor/destructor, regionSize is the most data written in one frame
+    StreamBuffer(GLenum target, std::size_t regionSize);
+    ~StreamBuffer();
+    // reserves size bytes in the frame's region (continuing in the next one if they don't fit anymore) and
+    // returns where to write them; nullptr if size exceeds a region
+    void* Reserve(std::size_t size, std::size_t alignment = 1);
+    // returns how many bytes can still be reserved in the frame's region
+    std::size_t Available(std::size_t alignment = 1) const;
+    // hands the first size bytes written into the last reservation to the GPU and returns their offset within the buffer
+    std::size_t Commit(std::size_t size);
+    // fences the frame's region after its last draw and moves on to the next one; call it once per frame
+    void EndFrame();
+    // returns true if the buffer is persistently mapped
+    bool Persistent() const;
+private:
+    GLenum         target;
+    std::size_t    regionSize;
+    unsigned int   region;             // region currently written to
+    std::size_t    cursor;             // offset of the first unused byte within the buffer
+    std::size_t    reserved;           // offset of the last reservation
+    unsigned char* mapped;             // persistently mapped storage (nullptr if orphaning)
+    bool           reserving;          // whether a reservation is waiting to be committed
+    GLsync         fences[REGION_COUNT];
+    // fences the current region and moves on to the next one, waiting for the GPU to be done with it
+    void nextRegion();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include <glad/glad.h>
+
+#include "offscreen_context.h"
+#include "program_cache.h"
+#include "resource_manager.h"
+#include "state_cache.h"
+#include "stream_buffer.h"
+#include "text_renderer.h"
+
+#include <cmath>
+#include <iostream>
+
+// Checks that the text styles reach the text shader even when another
+// program was bound in between and the style's color didn't change (the
+// shadowed color is then not uploaded again). Run from the project folder.
+
+// compares a float uniform of a program with the expected value; returns false and reports if it differs
+static bool expectUniform(unsigned int program, const char* name, float expected)
+{
+    float value = 0.0f;
+    glGetUniformfv(program, glGetUniformLocation(program, name), &value);
+    if (std::fabs(value - expected) > 1e-6f)
+    {
+        std::cout << "ERROR::TEXT_STYLE_TEST: " << name << " is " << value << " instead of " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    OffscreenContext context;
+    if (!context.Create(64, 64, 0))
+        return 1;
+    if (!gladLoadGLLoader(OffscreenContext::GetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    StreamBuffer::GetProcAddress = OffscreenContext::GetProcAddress;
+    ProgramCache::GetProcAddress = OffscreenContext::GetProcAddress;
+
+    bool passed = true;
+    {
+        TextRenderer text(800, 600);
+        Shader sprite = ResourceManager::LoadShader("shaders/sprite.vs", "shaders/sprite.frag", nullptr, "sprite");
+        // widths are stored as fractions of the distance field's range, 8 pixels wide on either side
+        glm::vec4 color(1.0f, 0.0f, 0.0f, 1.0f);
+        text.SetOutline(color, 2.0f);
+        sprite.Use();
+        text.SetOutline(color, 4.0f);
+        passed &= expectUniform(text.TextShader.ID, "outlineWidth", 4.0f / 16.0f);
+        text.SetGlow(color, 2.0f);
+        sprite.Use();
+        text.SetGlow(color, 6.0f);
+        passed &= expectUniform(text.TextShader.ID, "glowWidth", 6.0f / 16.0f);
+        passed &= glGetError() == GL_NO_ERROR;
+    }
+    ResourceManager::Clear();
+    std::cout << (passed ? "text styles ok" : "text styles FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
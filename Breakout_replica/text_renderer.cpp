@@ -6,135 +6,423 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
 #include "text_renderer.h"
 #include "resource_manager.h"
+#include "state_cache.h"
+
+// pixels left free around each glyph in the atlas to avoid bleeding
+static const unsigned int PADDING = 1;
+
+
+TextLabel::TextLabel()
+    : x(0.0f), y(0.0f), scale(1.0f), color(1.0f), dirty(true), generation(0), pages(0)
+{
+}
+
+void TextLabel::SetText(const char* text, std::size_t length)
+{
+    if (this->text.compare(0, std::string::npos, text, length) == 0)
+        return;
+    this->text.assign(text, length); // reuses the string's storage when it fits
+    this->dirty = true;
+}
+
+void TextLabel::SetText(const std::string& text)
+{
+    this->SetText(text.data(), text.size());
+}
+
+void TextLabel::SetStyle(float x, float y, float scale, glm::vec3 color)
+{
+    if (this->x == x && this->y == y && this->scale == scale && this->color == color)
+        return;
+    this->x = x;
+    this->y = y;
+    this->scale = scale;
+    this->color = color;
+    this->dirty = true;
+}
 
 
 TextRenderer::TextRenderer(unsigned int width, unsigned int height)
+    : Atlas(0), ft(nullptr), face(nullptr), capHeight(0.0f), flushCount(1), vertexStream(GL_ARRAY_BUFFER, sizeof(TextVertex) * 6 * MAX_GLYPHS), vertices(nullptr), vertexCount(0), vertexCapacity(0), pendingPages(0), generation(0), fontGeneration(0)
 {
     // load and configure shader
     this->TextShader = ResourceManager::LoadShader("shaders/text.vs", "shaders/text.frag", nullptr, "text");
     this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
     this->TextShader.SetInteger("text", 0);
+    this->outlineColorUniform = this->TextShader.GetUniform<glm::vec4>("outlineColor");
+    this->outlineWidthUniform = this->TextShader.GetUniform<float>("outlineWidth");
+    this->glowColorUniform = this->TextShader.GetUniform<glm::vec4>("glowColor");
+    this->glowWidthUniform = this->TextShader.GetUniform<float>("glowWidth");
+    this->SetOutline(glm::vec4(0.0f), 0.0f);
+    this->SetGlow(glm::vec4(0.0f), 0.0f);
     // configure VAO/VBO for texture quads
     glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &this->VBO);
-    glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    StateCache::BindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexStream.ID);
+    setupVertexAttributes();
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    StateCache::BindVertexArray(0);
+    // allocate the atlas pages, they're filled as glyphs are needed
+    glGenTextures(1, &this->Atlas);
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Atlas);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, PAGE_SIZE, PAGE_SIZE, PAGE_COUNT, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    this->clearGlyphs();
+}
+
+TextRenderer::~TextRenderer()
+{
+    if (this->face)
+        FT_Done_Face(this->face);
+    if (this->ft)
+        FT_Done_FreeType(this->ft);
 }
 
 void TextRenderer::Load(std::string font, unsigned int fontSize)
 {
-    // first clear the previously loaded Characters
-    this->Characters.clear();
-    // then initialize and load the FreeType library
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-    // load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, font.c_str(), 0, &face))
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-    // set size to load glyphs as
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-    // disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    // then for the first 128 ASCII characters, pre-load/compile their characters and store them
-    for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
+    // first drop the glyphs of the previously loaded font
+    this->Flush();
+    this->clearGlyphs();
+    this->fontGeneration = ++this->generation;
+    if (this->face)
+    {
+        FT_Done_Face(this->face);
+        this->face = nullptr;
+    }
+    // then initialize the FreeType library (once)
+    if (!this->ft)
     {
-        // load character glyph 
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+        if (FT_Init_FreeType(&this->ft)) // all functions return a value different than 0 whenever an error occurred
         {
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
+            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+            this->ft = nullptr;
+            return;
         }
-        // generate texture
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-        // set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
-        };
-        Characters.insert(std::pair<char, Character>(c, character));
+        // widen the distance fields (FreeType defaults to 2 pixels) so outlines and glows have room
+        FT_Int spread = SDF_SPREAD;
+        FT_Property_Set(this->ft, "sdf", "spread", &spread);
+        FT_Property_Set(this->ft, "bsdf", "spread", &spread);
+    }
+    // load font as face, it's kept open to render glyphs as they're needed
+    if (FT_New_Face(this->ft, font.c_str(), 0, &this->face))
+    {
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        this->face = nullptr;
+        return;
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    // set size to load glyphs as
+    FT_Set_Pixel_Sizes(this->face, 0, fontSize);
+    // distance fields extend SDF_SPREAD pixels beyond the outline, the visible glyph starts within
+    const Character* reference = this->cacheGlyph('H');
+    this->capHeight = reference ? static_cast<float>(reference->Bearing.y - SDF_SPREAD) : 0.0f;
+}
+
+void TextRenderer::RenderText(const std::string& text, float x, float y, float scale, glm::vec3 color)
+{
+    std::size_t length = std::min<std::size_t>(text.size(), MAX_GLYPHS);
+    // render missing glyphs first, this may flush to make room in the atlas
+    this->cacheGlyphs(text.data(), length);
+    TextVertex* out = this->reserveVertices(static_cast<unsigned int>(6 * length));
+    this->vertexCount += this->layoutText(text.data(), length, x, y, scale, color, out, this->pendingPages);
 }
 
-void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color)
+void TextRenderer::Draw(TextLabel& label)
 {
-    // activate corresponding render state	
+    // the layout is stale if the font changed or one of the pages it samples was evicted since
+    bool stale = label.dirty || label.generation < this->fontGeneration;
+    for (unsigned int page = 0; page < PAGE_COUNT && !stale; ++page)
+        stale = (label.pages & (1u << page)) && this->pages[page].Generation > label.generation;
+    if (stale)
+    {
+        // lay out the label once and keep the result
+        std::size_t length = std::min<std::size_t>(label.text.size(), MAX_GLYPHS);
+        this->cacheGlyphs(label.text.data(), length);
+        label.vertices.resize(6 * length);
+        label.pages = 0;
+        label.vertices.resize(this->layoutText(label.text.data(), length, label.x, label.y, label.scale, label.color, label.vertices.data(), label.pages));
+        label.generation = this->generation;
+        label.dirty = false;
+    }
+    if (label.vertices.empty())
+        return;
+    // the label's pages are in use even though none of its glyphs were looked up
+    for (unsigned int page = 0; page < PAGE_COUNT; ++page)
+        if (label.pages & (1u << page))
+            this->pages[page].LastUsed = this->flushCount;
+    this->pendingPages |= label.pages;
+    unsigned int count = static_cast<unsigned int>(label.vertices.size());
+    std::memcpy(this->reserveVertices(count), label.vertices.data(), sizeof(TextVertex) * count);
+    this->vertexCount += count;
+}
+
+void TextRenderer::Flush()
+{
+    // pages used before this point may be evicted without flushing again
+    ++this->flushCount;
+    this->pendingPages = 0;
+    if (this->vertices == nullptr)
+        return;
     this->TextShader.Use();
-    this->TextShader.SetVector3f("textColor", color);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(this->VAO);
+    StateCache::ActiveTexture(GL_TEXTURE0);
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Atlas);
+    // render all queued glyph quads at once
+    std::size_t offset = this->vertexStream.Commit(sizeof(TextVertex) * this->vertexCount);
+    this->vertices = nullptr;
+    StateCache::BindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, static_cast<GLint>(offset / sizeof(TextVertex)), this->vertexCount);
+    this->vertexCount = 0;
+}
+
+void TextRenderer::EndFrame()
+{
+    // the next frame's text is written into another region while the GPU reads this one's
+    this->vertexStream.EndFrame();
+}
 
+void TextRenderer::SetOutline(glm::vec4 color, float width)
+{
+    // a distance of 0.5 in the field is the glyph's edge, 1.0 lies SDF_SPREAD pixels inside it
+    this->TextShader.Use();
+    this->TextShader.Set(this->outlineColorUniform, color);
+    this->TextShader.Set(this->outlineWidthUniform, std::min(width, float(SDF_SPREAD)) / (2.0f * SDF_SPREAD));
+}
+
+void TextRenderer::SetGlow(glm::vec4 color, float width)
+{
+    this->TextShader.Use();
+    this->TextShader.Set(this->glowColorUniform, color);
+    this->TextShader.Set(this->glowWidthUniform, std::min(width, float(SDF_SPREAD)) / (2.0f * SDF_SPREAD));
+}
+
+TextVertex* TextRenderer::reserveVertices(unsigned int count)
+{
+    // make sure there's room for the quads in the reserved vertex storage
+    if (this->vertices != nullptr && this->vertexCount + count > this->vertexCapacity)
+        this->Flush();
+    if (this->vertices == nullptr)
+    {
+        // a batch takes what's left of the frame's region, so the batches of several flushes (one per
+        // session's HUD) share it; only if the quads don't fit anymore does it take a region of its own
+        this->vertexCapacity = static_cast<unsigned int>(std::min<std::size_t>(this->vertexStream.Available(sizeof(TextVertex)) / sizeof(TextVertex), 6 * MAX_GLYPHS));
+        if (this->vertexCapacity < count)
+            this->vertexCapacity = 6 * MAX_GLYPHS;
+        this->vertices = static_cast<TextVertex*>(this->vertexStream.Reserve(sizeof(TextVertex) * this->vertexCapacity, sizeof(TextVertex)));
+    }
+    return this->vertices + this->vertexCount;
+}
+
+void TextRenderer::cacheGlyphs(const char* text, std::size_t length)
+{
+    const char* end = text + length;
+    while (text != end)
+        this->cacheGlyph(decodeUtf8(text, end));
+}
+
+unsigned int TextRenderer::layoutText(const char* text, std::size_t length, float x, float y, float scale, glm::vec3 color, TextVertex* out, unsigned int& pages) const
+{
+    TextVertex* quad = out;
+    const char* end = text + length;
     // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+    while (text != end)
     {
-        Character ch = Characters[*c];
-
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
-
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 0.0f },
-
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f }
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        unsigned int index = this->glyphIndices.Find(decodeUtf8(text, end));
+        if (index == GlyphMap::NOT_FOUND)
+            continue; // evicted again while caching an overly long string, skip it
+        const Character& ch = this->glyphs[index];
+        if (ch.Page != NO_PAGE)
+        {
+            float xpos = x + ch.Bearing.x * scale;
+            float ypos = y + (this->capHeight - ch.Bearing.y) * scale;
+
+            float w = ch.Size.x * scale;
+            float h = ch.Size.y * scale;
+            float page = static_cast<float>(ch.Page);
+            // write the glyph's quad
+            quad[0] = { glm::vec4(xpos,     ypos + h, ch.AtlasMin.x, ch.AtlasMax.y), color, page };
+            quad[1] = { glm::vec4(xpos + w, ypos,     ch.AtlasMax.x, ch.AtlasMin.y), color, page };
+            quad[2] = { glm::vec4(xpos,     ypos,     ch.AtlasMin.x, ch.AtlasMin.y), color, page };
+            quad[3] = { glm::vec4(xpos,     ypos + h, ch.AtlasMin.x, ch.AtlasMax.y), color, page };
+            quad[4] = { glm::vec4(xpos + w, ypos + h, ch.AtlasMax.x, ch.AtlasMax.y), color, page };
+            quad[5] = { glm::vec4(xpos + w, ypos,     ch.AtlasMax.x, ch.AtlasMin.y), color, page };
+            quad += 6;
+            pages |= 1u << ch.Page;
+        }
         // now advance cursors for next glyph
         x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    return static_cast<unsigned int>(quad - out);
+}
+
+const Character* TextRenderer::cacheGlyph(char32_t codepoint)
+{
+    unsigned int index = this->glyphIndices.Find(codepoint);
+    if (index != GlyphMap::NOT_FOUND)
+    {
+        Character& glyph = this->glyphs[index];
+        if (glyph.Page != NO_PAGE)
+            this->pages[glyph.Page].LastUsed = this->flushCount;
+        return &glyph;
+    }
+    if (!this->face)
+        return nullptr;
+    // load character glyph and render its signed distance field
+    Character glyph = { glm::vec2(0.0f), glm::vec2(0.0f), glm::ivec2(0), glm::ivec2(0), 0, NO_PAGE, codepoint };
+    if (FT_Load_Char(this->face, codepoint, FT_LOAD_DEFAULT) || FT_Render_Glyph(this->face->glyph, FT_RENDER_MODE_SDF))
+        std::cout << "ERROR::FREETYTPE: Failed to load Glyph " << static_cast<unsigned int>(codepoint) << std::endl; // cached as an empty glyph
+    else
+    {
+        FT_Bitmap& bitmap = this->face->glyph->bitmap;
+        glyph.Bearing = glm::ivec2(this->face->glyph->bitmap_left, this->face->glyph->bitmap_top);
+        glyph.Advance = static_cast<unsigned int>(this->face->glyph->advance.x);
+        // find a spot in the atlas and upload the glyph's pixels, bitmap rows may be padded
+        glm::uvec2 position;
+        if (bitmap.width > 0 && bitmap.rows > 0 && this->allocateGlyph(bitmap.width, bitmap.rows, glyph.Page, position))
+        {
+            glyph.Size = glm::ivec2(bitmap.width, bitmap.rows);
+            glyph.AtlasMin = glm::vec2(position) / float(PAGE_SIZE);
+            glyph.AtlasMax = glm::vec2(position + glm::uvec2(glyph.Size)) / float(PAGE_SIZE);
+            StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Atlas);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap.pitch);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, position.x, position.y, glyph.Page, bitmap.width, bitmap.rows, 1, GL_RED, GL_UNSIGNED_BYTE, bitmap.buffer);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            this->pages[glyph.Page].LastUsed = this->flushCount;
+        }
+    }
+    // now store character for later use
+    if (this->freeGlyphs.empty())
+    {
+        index = static_cast<unsigned int>(this->glyphs.size());
+        this->glyphs.push_back(glyph);
+    }
+    else
+    {
+        index = this->freeGlyphs.back();
+        this->freeGlyphs.pop_back();
+        this->glyphs[index] = glyph;
+    }
+    this->glyphIndices.Insert(codepoint, index);
+    return &this->glyphs[index];
+}
+
+bool TextRenderer::allocateGlyph(unsigned int width, unsigned int height, unsigned int& page, glm::uvec2& position)
+{
+    if (width + 2 * PADDING > PAGE_SIZE || height + 2 * PADDING > PAGE_SIZE)
+        return false;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        for (page = 0; page < PAGE_COUNT; ++page)
+        {
+            AtlasPage& atlasPage = this->pages[page];
+            // prefer the lowest existing shelf the glyph fits on
+            Shelf* best = nullptr;
+            for (Shelf& shelf : atlasPage.Shelves)
+                if (height <= shelf.Height && shelf.X + width + PADDING <= PAGE_SIZE && (!best || shelf.Height < best->Height))
+                    best = &shelf;
+            // otherwise open a new shelf below the others
+            if (!best && atlasPage.NextY + height + PADDING <= PAGE_SIZE)
+            {
+                atlasPage.Shelves.push_back({ atlasPage.NextY, height, PADDING });
+                atlasPage.NextY += height + PADDING;
+                best = &atlasPage.Shelves.back();
+            }
+            if (best)
+            {
+                position = glm::uvec2(best->X, best->Y);
+                best->X += width + PADDING;
+                return true;
+            }
+        }
+        // all pages are full, make room by evicting the least recently used one
+        unsigned int lru = 0;
+        for (unsigned int i = 1; i < PAGE_COUNT; ++i)
+            if (this->pages[i].LastUsed < this->pages[lru].LastUsed)
+                lru = i;
+        this->evictPage(lru);
+    }
+    return false;
+}
+
+void TextRenderer::evictPage(unsigned int page)
+{
+    // quads queued since the last flush may still sample the page
+    if (this->pendingPages & (1u << page))
+        this->Flush();
+    for (unsigned int i = 0; i < this->glyphs.size(); ++i)
+    {
+        Character& glyph = this->glyphs[i];
+        if (glyph.Page == page)
+        {
+            this->glyphIndices.Erase(glyph.Codepoint);
+            this->freeGlyphs.push_back(i);
+            glyph.Page = NO_PAGE;
+        }
+    }
+    // the distance fields fade to zero at their border, so cleared padding keeps glyphs from bleeding
+    std::vector<unsigned char> empty(PAGE_SIZE * PAGE_SIZE, 0);
+    StateCache::BindTexture(GL_TEXTURE_2D_ARRAY, this->Atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, page, PAGE_SIZE, PAGE_SIZE, 1, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    this->pages[page].Shelves.clear();
+    this->pages[page].NextY = PADDING;
+    this->pages[page].LastUsed = 0;
+    // labels laid out with glyphs from this page need to be laid out again
+    this->pages[page].Generation = ++this->generation;
+}
+
+void TextRenderer::clearGlyphs()
+{
+    this->glyphs.clear();
+    this->freeGlyphs.clear();
+    this->glyphIndices.Clear();
+    for (unsigned int page = 0; page < PAGE_COUNT; ++page)
+    {
+        this->pages[page].LastUsed = 0;
+        this->evictPage(page);
+    }
+}
+
+void TextRenderer::setupVertexAttributes()
+{
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Vertex));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Page));
+}
+
+char32_t TextRenderer::decodeUtf8(const char*& text, const char* end)
+{
+    unsigned char lead = static_cast<unsigned char>(*text++);
+    if (lead < 0x80)
+        return lead;
+    // the lead byte tells how many continuation bytes follow
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || lead > 0xF4)
+        return 0xFFFD; // replacement character
+    char32_t codepoint = lead & (0x3F >> extra);
+    for (; extra > 0; --extra)
+    {
+        if (text == end || (static_cast<unsigned char>(*text) & 0xC0) != 0x80)
+            return 0xFFFD;
+        codepoint = (codepoint << 6) | (static_cast<unsigned char>(*text++) & 0x3F);
+    }
+    return codepoint;
 }
\ No newline at end of file
@@ -9,43 +9,168 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "texture.h"
 #include "shader.h"
+#include "glyph_map.h"
+#include "stream_buffer.h"
+
+// FreeType handles, kept opaque so users of the renderer don't need FreeType's headers
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_*    FT_Face;
 
 
 /// Holds all state information relevant to a character as loaded using FreeType
 struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
+    glm::vec2    AtlasMin;  // texture coordinates of the glyph's top-left corner in the atlas
+    glm::vec2    AtlasMax;  // texture coordinates of the glyph's bottom-right corner in the atlas
     glm::ivec2   Size;      // size of glyph
     glm::ivec2   Bearing;   // offset from baseline to left/top of glyph
     unsigned int Advance;   // horizontal offset to advance to next glyph
+    unsigned int Page;      // atlas page holding the glyph (NO_PAGE for empty glyphs)
+    char32_t     Codepoint; // Unicode codepoint the glyph was rendered for
+};
+
+/// Vertex of a glyph quad as written into the text vertex buffer
+struct TextVertex {
+    glm::vec4 Vertex; // <vec2 pos, vec2 tex>
+    glm::vec3 Color;
+    float     Page;   // atlas page (array layer) to sample
+};
+
+
+// A retained piece of text. Its glyph quads are laid out once and kept,
+// and are only laid out again when the string, the style or the loaded
+// font changes, or an atlas page its glyphs are on is evicted; drawing
+// unchanged text just copies the quads into the
+// frame's text batch, so labels are drawn by the same single draw call as
+// all other text. Labels own no OpenGL objects and may outlive the context.
+class TextLabel
+{
+public:
+    // constructor
+    TextLabel();
+    // changes the displayed string; nothing happens if it is unchanged
+    void SetText(const char* text, std::size_t length);
+    void SetText(const std::string& text);
+    // changes position, scale and color; nothing happens if they are unchanged
+    void SetStyle(float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
+private:
+    friend class TextRenderer;
+    // label state
+    std::string  text;
+    float        x, y, scale;
+    glm::vec3    color;
+    // layout state
+    bool                    dirty;
+    unsigned int            generation; // renderer generation the current layout was made at
+    unsigned int            pages;      // bit mask of the atlas pages the layout samples
+    std::vector<TextVertex> vertices;   // glyph quads of the current layout
 };
 
 
 // A renderer class for rendering text displayed by a font loaded using the 
-// FreeType library. A single font is loaded, processed into a list of Character
-// items for later rendering.
+// FreeType library. Strings are UTF-8; glyphs are rendered lazily as signed
+// distance fields the first time a codepoint is seen and shelf-packed into
+// the pages of an atlas texture array, so startup stays fast and any script
+// can be shown while the atlas memory stays fixed. When all pages are full
+// the least recently used page is evicted. The distance fields render crisp
+// text (with optional outline and glow) at any scale. Strings
+// are laid out into a streamed vertex buffer by RenderText and all text of a
+// frame is drawn with a single draw call by Flush; retained TextLabels copy
+// their cached layout into the same buffer.
 class TextRenderer
 {
 public:
-    // holds a list of pre-compiled Characters
-    std::map<char, Character> Characters;
+    // array texture holding all glyph pages
+    unsigned int Atlas;
     // shader used for text rendering
     Shader TextShader;
-    // constructor
+    // constructor/destructor
     TextRenderer(unsigned int width, unsigned int height);
-    // pre-compiles a list of characters from the given font
+    ~TextRenderer();
+    // opens the given font, glyphs are rendered from it on first use
     void Load(std::string font, unsigned int fontSize);
-    // renders a string of text using the precompiled list of characters
-    void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
+    // lays out a string of UTF-8 text and queues it for rendering
+    void RenderText(const std::string& text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
+    // queues a retained label for rendering, laying it out again only if it changed
+    void Draw(TextLabel& label);
+    // draws all text queued since the last flush
+    void Flush();
+    // hands the frame's text vertices to the GPU, call it once per frame after the last flush
+    void EndFrame();
+    // outlines all text with the given color; width is in pixels at the loaded font size (up to SDF_SPREAD)
+    void SetOutline(glm::vec4 color, float width);
+    // surrounds all text with a soft glow; width is in pixels at the loaded font size (up to SDF_SPREAD)
+    void SetGlow(glm::vec4 color, float width);
 private:
+    // a row of glyphs of at most Height pixels within an atlas page
+    struct Shelf {
+        unsigned int Y, Height;
+        unsigned int X; // first free column
+    };
+    struct AtlasPage {
+        std::vector<Shelf> Shelves;
+        unsigned int       NextY;    // first row not covered by a shelf
+        unsigned int       LastUsed;   // flush in which a glyph of this page was last used
+        unsigned int       Generation; // generation the page was last evicted at
+    };
+    // maximum amount of glyphs queued before an intermediate flush is required
+    static const unsigned int MAX_GLYPHS = 4096;
+    // distance in pixels the distance fields extend beyond each glyph's outline
+    static const int SDF_SPREAD = 8;
+    // atlas budget: PAGE_COUNT layers of PAGE_SIZE x PAGE_SIZE 8-bit texels
+    static const unsigned int PAGE_SIZE = 512;
+    static const unsigned int PAGE_COUNT = 4;
+    static const unsigned int NO_PAGE = PAGE_COUNT;
+    // font state, the face stays open to render glyphs on demand
+    FT_Library ft;
+    FT_Face    face;
+    // offset from the baseline to the top of a capital letter
+    float capHeight;
+    // glyph cache
+    std::vector<Character>    glyphs;
+    std::vector<unsigned int> freeGlyphs; // indices of unused entries in glyphs
+    GlyphMap                  glyphIndices;
+    AtlasPage                 pages[PAGE_COUNT];
+    unsigned int              flushCount;
+    // style uniforms
+    Uniform<glm::vec4> outlineColorUniform, glowColorUniform;
+    Uniform<float>     outlineWidthUniform, glowWidthUniform;
     // render state
-    unsigned int VAO, VBO;
+    unsigned int VAO;
+    StreamBuffer vertexStream;
+    TextVertex*  vertices; // reserved vertex buffer storage (nullptr if nothing is queued)
+    unsigned int vertexCount, vertexCapacity;
+    // atlas pages sampled by the quads queued since the last flush (bit mask)
+    unsigned int pendingPages;
+    // incremented whenever a page is evicted; labels laid out before one of their pages was evicted lay out again
+    unsigned int generation;
+    // generation the current font was loaded at, every label laid out before lays out again
+    unsigned int fontGeneration;
+    // returns room for count more vertices in the batch, flushing it first if they don't fit
+    TextVertex* reserveVertices(unsigned int count);
+    // makes sure all glyphs of a string are in the atlas, rendering missing ones
+    void cacheGlyphs(const char* text, std::size_t length);
+    // writes the glyph quads of a string into out (at most 6 vertices per byte) and adds the atlas pages they
+    // sample to pages; returns the vertex count
+    unsigned int layoutText(const char* text, std::size_t length, float x, float y, float scale, glm::vec3 color, TextVertex* out, unsigned int& pages) const;
+    // returns the glyph of a codepoint, rendering it into the atlas on first use
+    const Character* cacheGlyph(char32_t codepoint);
+    // finds room for a w x h glyph in the atlas, evicting a page if necessary; returns false if it can never fit
+    bool allocateGlyph(unsigned int width, unsigned int height, unsigned int& page, glm::uvec2& position);
+    // drops all glyphs of an atlas page, flushing first if queued quads sample it
+    void evictPage(unsigned int page);
+    // clears the glyph cache and all atlas pages
+    void clearGlyphs();
+    // sets up the vertex attributes of the currently bound vertex buffer
+    static void setupVertexAttributes();
+    // decodes the UTF-8 sequence at text and advances past it
+    static char32_t decodeUtf8(const char*& text, const char* end);
 };
 
-#endif 
\ No newline at end of file
+#endif 
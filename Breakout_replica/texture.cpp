@@ -6,9 +6,11 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
 #include <iostream>
 
 #include "texture.h"
+#include "state_cache.h"
 
 
 Texture2D::Texture2D()
@@ -22,7 +24,7 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     this->Width = width;
     this->Height = height;
     // create Texture
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    StateCache::BindTexture(GL_TEXTURE_2D, this->ID);
     glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
@@ -30,10 +32,29 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture2D::GenerateCompressed(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const* data, const unsigned int* sizes)
+{
+    this->Width = width;
+    this->Height = height;
+    // create Texture with all of its mipmap levels
+    StateCache::BindTexture(GL_TEXTURE_2D, this->ID);
+    for (unsigned int level = 0; level < levels; ++level)
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, std::max(width >> level, 1u), std::max(height >> level, 1u), 0, sizes[level], data[level]);
+    // a chain that stops short of 1x1 is still complete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    // set Texture wrap and filter modes
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+    // unbind texture
+    StateCache::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    StateCache::BindTexture(GL_TEXTURE_2D, this->ID);
 }
\ No newline at end of file
@@ -32,6 +32,9 @@ public:
     Texture2D();
     // generates texture from image data
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
+    // generates texture from block compressed image data in Internal_Format, one image (and its size in bytes)
+    // per mipmap level starting with the full size one
+    void GenerateCompressed(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const* data, const unsigned int* sizes);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const;
 };
@@ -0,0 +1,303 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "texture_compressor.h"
+#include "ktx_file.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// an RGBA image, rows from top to bottom
+struct Image {
+    unsigned int               Width, Height;
+    std::vector<unsigned char> Pixels;
+};
+
+// halves an image in both directions (down to 1 pixel) by averaging 2x2 areas, odd edges repeat their last pixel
+static Image downsample(const Image& image)
+{
+    unsigned int width = std::max(image.Width / 2, 1u), height = std::max(image.Height / 2, 1u);
+    Image result = { width, height, std::vector<unsigned char>(width * height * 4) };
+    for (unsigned int y = 0; y < result.Height; ++y)
+    {
+        unsigned int y0 = std::min(y * 2, image.Height - 1), y1 = std::min(y * 2 + 1, image.Height - 1);
+        for (unsigned int x = 0; x < result.Width; ++x)
+        {
+            unsigned int x0 = std::min(x * 2, image.Width - 1), x1 = std::min(x * 2 + 1, image.Width - 1);
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                unsigned int sum = image.Pixels[(y0 * image.Width + x0) * 4 + c] + image.Pixels[(y0 * image.Width + x1) * 4 + c]
+                    + image.Pixels[(y1 * image.Width + x0) * 4 + c] + image.Pixels[(y1 * image.Width + x1) * 4 + c];
+                result.Pixels[(y * result.Width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+static std::uint16_t pack565(const float color[3])
+{
+    int r = std::clamp(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = std::clamp(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = std::clamp(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return static_cast<std::uint16_t>(r << 11 | g << 5 | b);
+}
+
+static void unpack565(std::uint16_t packed, int color[3])
+{
+    int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = r << 3 | r >> 2;
+    color[1] = g << 2 | g >> 4;
+    color[2] = b << 3 | b >> 2;
+}
+
+// picks the closest of the four colors between two endpoints (c0 > c1) for every pixel;
+// returns the 2-bit indices and adds the squared error to error
+static std::uint32_t fitColors(const unsigned char pixels[16][4], std::uint16_t c0, std::uint16_t c1, int& error)
+{
+    int palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    std::uint32_t indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0, bestError = 0;
+        for (int p = 0; p < 4; ++p)
+        {
+            int dr = pixels[i][0] - palette[p][0], dg = pixels[i][1] - palette[p][1], db = pixels[i][2] - palette[p][2];
+            int e = dr * dr + dg * dg + db * db;
+            if (p == 0 || e < bestError)
+            {
+                best = p;
+                bestError = e;
+            }
+        }
+        indices |= static_cast<std::uint32_t>(best) << (2 * i);
+        error += bestError;
+    }
+    return indices;
+}
+
+// writes the endpoints and indices of a color block, using the four color mode (c0 > c1) whenever the endpoints differ
+static void writeColorBlock(const unsigned char pixels[16][4], std::uint16_t c0, std::uint16_t c1, unsigned char* out, int& error)
+{
+    if (c0 < c1)
+        std::swap(c0, c1);
+    std::uint32_t indices = c0 == c1 ? 0 : fitColors(pixels, c0, c1, error);
+    out[0] = static_cast<unsigned char>(c0);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    for (int b = 0; b < 4; ++b)
+        out[4 + b] = static_cast<unsigned char>(indices >> (8 * b));
+}
+
+// encodes the colors of a 4x4 block into 8 bytes of BC1
+static void encodeColorBlock(const unsigned char pixels[16][4], unsigned char* out)
+{
+    // principal axis of the colors, by power iteration on their covariance
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += pixels[i][c] / 16.0f;
+    float covariance[3][3] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < 3; ++a)
+            for (int b = 0; b < 3; ++b)
+                covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[3];
+        for (int a = 0; a < 3; ++a)
+            next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+        float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+        if (length < 1e-6f)
+            break; // all colors are the same
+        for (int a = 0; a < 3; ++a)
+            axis[a] = next[a] / length;
+    }
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (int a = 0; a < 3; ++a)
+        axis[a] /= length;
+    // endpoints at the extremes along the axis, moved inwards a bit as the extremes are rarely hit exactly
+    float minimum = 0.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    float inset = (maximum - minimum) / 16.0f;
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = mean[c] + axis[c] * (maximum - inset);
+        e1[c] = mean[c] + axis[c] * (minimum + inset);
+    }
+    int error = 0;
+    writeColorBlock(pixels, pack565(e0), pack565(e1), out, error);
+
+    // refine the endpoints once by least squares, given the indices picked for them
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    std::uint16_t c0 = static_cast<std::uint16_t>(out[0] | out[1] << 8), c1 = static_cast<std::uint16_t>(out[2] | out[3] << 8);
+    if (c0 == c1)
+        return;
+    std::uint32_t indices = static_cast<std::uint32_t>(out[4] | out[5] << 8 | out[6] << 16 | out[7] << 24);
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += a * pixels[i][c];
+            bx[c] += b * pixels[i][c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f)
+        return;
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+        e1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+    }
+    unsigned char refined[8];
+    int refinedError = 0;
+    writeColorBlock(pixels, pack565(e0), pack565(e1), refined, refinedError);
+    if (refinedError < error)
+        std::copy(refined, refined + 8, out);
+}
+
+// encodes the alpha of a 4x4 block into 8 bytes of BC3's alpha block, interpolating 8 values between the extremes
+static void encodeAlphaBlock(const unsigned char pixels[16][4], unsigned char* out)
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        a0 = std::max(a0, static_cast<int>(pixels[i][3]));
+        a1 = std::min(a1, static_cast<int>(pixels[i][3]));
+    }
+    std::uint64_t indices = 0;
+    if (a0 > a1)
+    {
+        int palette[8] = { a0, a1 };
+        for (int p = 2; p < 8; ++p)
+            palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            for (int p = 1; p < 8; ++p)
+                if (std::abs(pixels[i][3] - palette[p]) < std::abs(pixels[i][3] - palette[best]))
+                    best = p;
+            indices |= static_cast<std::uint64_t>(best) << (3 * i);
+        }
+    }
+    out[0] = static_cast<unsigned char>(a0);
+    out[1] = static_cast<unsigned char>(a1);
+    for (int b = 0; b < 6; ++b)
+        out[2 + b] = static_cast<unsigned char>(indices >> (8 * b));
+}
+
+// compresses an image into rows of BC1 blocks, or BC3 blocks if it has alpha
+static std::vector<unsigned char> compress(const Image& image, bool alpha)
+{
+    unsigned int columns = (image.Width + 3) / 4, rows = (image.Height + 3) / 4;
+    std::vector<unsigned char> blocks(columns * rows * (alpha ? 16 : 8));
+    unsigned char* out = blocks.data();
+    for (unsigned int row = 0; row < rows; ++row)
+    {
+        for (unsigned int column = 0; column < columns; ++column)
+        {
+            // blocks sticking out of the image repeat its last row and column
+            unsigned char pixels[16][4];
+            for (unsigned int i = 0; i < 16; ++i)
+            {
+                unsigned int x = std::min(column * 4 + i % 4, image.Width - 1), y = std::min(row * 4 + i / 4, image.Height - 1);
+                std::copy_n(&image.Pixels[(y * image.Width + x) * 4], 4, pixels[i]);
+            }
+            if (alpha)
+            {
+                encodeAlphaBlock(pixels, out);
+                out += 8;
+            }
+            encodeColorBlock(pixels, out);
+            out += 8;
+        }
+    }
+    return blocks;
+}
+
+// converts a single image into a KTX file with all of its mipmap levels
+static bool convert(const std::filesystem::path& source, const std::filesystem::path& target)
+{
+    int width, height, channels;
+    unsigned char* data = stbi_load(source.string().c_str(), &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSOR: Failed to load " << source.string() << std::endl;
+        return false;
+    }
+    Image image = { static_cast<unsigned int>(width), static_cast<unsigned int>(height), std::vector<unsigned char>(data, data + width * height * 4) };
+    stbi_image_free(data);
+    bool alpha = channels == 2 || channels == 4;
+    std::vector<std::vector<unsigned char>> levels = { compress(image, alpha) };
+    while (image.Width > 1 || image.Height > 1)
+    {
+        image = downsample(image);
+        levels.push_back(compress(image, alpha));
+    }
+    if (!WriteKtx(target.string().c_str(), alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT, alpha ? GL_RGBA : GL_RGB, width, height, levels))
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSOR: Failed to write " << target.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+unsigned int CompressTextures(const char* directory)
+{
+    unsigned int failures = 0;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension != ".png" && extension != ".jpg" && extension != ".jpeg")
+            continue;
+        std::filesystem::path target = entry.path();
+        target.replace_extension(".ktx");
+        if (std::filesystem::exists(target) && std::filesystem::last_write_time(target) >= entry.last_write_time())
+            continue;
+        std::cout << "Compressing " << entry.path().string() << std::endl;
+        if (!convert(entry.path(), target))
+            ++failures;
+    }
+    if (error)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSOR: Failed to read " << directory << std::endl;
+        ++failures;
+    }
+    return failures;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TEXTURE_COMPRESSOR_H
+#define TEXTURE_COMPRESSOR_H
+
+
+// Converts the PNG and JPEG images of a folder into KTX files next to
+// them (same name, .ktx extension) that ResourceManager loads instead of
+// the images. Images with an alpha channel become BC3 (DXT5), opaque ones
+// BC1 (DXT1), at a quarter and an eighth of their uncompressed size. Each
+// gets a full mipmap chain, box filtered down to 1x1. The block endpoints
+// are fit along the principal axis of the block's colors and refined once
+// by least squares, which is fast and plenty for the game's sprites.
+// Images whose KTX file is newer are skipped. Returns the amount of images
+// that failed to convert.
+unsigned int CompressTextures(const char* directory);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "texture_loader.h"
+#include "ktx_file.h"
+#include "state_cache.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+struct TextureLoader::Request {
+    std::string                             File;
+    bool                                    Alpha;
+    bool                                    TryKtx;     // read the KTX file next to the image instead if there is one
+    Texture2D                               Texture;    // its formats are filled in by the worker, its object created by allocate
+    unsigned int                            Replaced;   // object of the texture it replaces, deleted once it's ready
+    Callback                                OnReady;
+    std::promise<Texture2D>                 Promise;
+    // decoded by a worker
+    bool                                    Failed;
+    bool                                    Compressed;
+    unsigned int                            Width, Height;
+    std::vector<std::vector<unsigned char>> Levels;     // block compressed mipmap levels, or the pixels of the image
+    // upload progress
+    unsigned int                            Level, Row; // next chunk starts at this row (of blocks if compressed) of this level
+    GLsync                                  Fence;      // after the last chunk
+    explicit Request(const Texture2D& texture)
+        : Alpha(false), TryKtx(true), Texture(texture), Replaced(texture.ID), Failed(false), Compressed(false), Width(0), Height(0), Level(0), Row(0), Fence(nullptr) { }
+};
+
+// waits for a fence if wait is set, otherwise only checks it; returns true if it has signaled
+static bool fenceSignaled(GLsync fence, bool wait)
+{
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (wait && result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+    return result != GL_TIMEOUT_EXPIRED;
+}
+
+
+TextureLoader::TextureLoader(unsigned int threads)
+    : decoding(0), stopping(false), nextStaging(0), pending(0)
+{
+    for (Staging& buffer : this->staging)
+    {
+        glGenBuffers(1, &buffer.PBO);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.PBO);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, CHUNK_SIZE, NULL, GL_STREAM_DRAW);
+        buffer.Fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    // the render thread keeps a core for itself
+    if (threads == 0)
+        threads = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+    for (unsigned int i = 0; i < threads; ++i)
+        this->workers.emplace_back(&TextureLoader::work, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->queued.notify_all();
+    for (std::thread& worker : this->workers)
+        worker.join();
+    for (Staging& buffer : this->staging)
+    {
+        if (buffer.Fence)
+            glDeleteSync(buffer.Fence);
+        glDeleteBuffers(1, &buffer.PBO);
+    }
+    // the textures of the requests that didn't complete
+    std::vector<RequestPtr> unfinished(this->transferring);
+    unfinished.insert(unfinished.end(), this->decodeQueue.begin(), this->decodeQueue.end());
+    unfinished.insert(unfinished.end(), this->decoded.begin(), this->decoded.end());
+    if (this->uploading)
+        unfinished.push_back(this->uploading);
+    for (const RequestPtr& request : unfinished)
+    {
+        if (request->Fence)
+            glDeleteSync(request->Fence);
+        if (request->Texture.ID != request->Replaced)
+            glDeleteTextures(1, &request->Texture.ID);
+    }
+    // deleted objects were unbound by the context behind the state cache's back
+    StateCache::Invalidate();
+}
+
+std::shared_future<Texture2D> TextureLoader::Load(const char* file, bool alpha, Callback onReady, const Texture2D& texture)
+{
+    RequestPtr request = std::make_shared<Request>(texture);
+    request->File = file;
+    request->Alpha = alpha;
+    request->OnReady = onReady;
+    std::shared_future<Texture2D> future = request->Promise.get_future().share();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->decodeQueue.push_back(request);
+        ++this->decoding;
+    }
+    this->queued.notify_one();
+    ++this->pending;
+    return future;
+}
+
+unsigned int TextureLoader::Update(float budget)
+{
+    this->process(budget, false);
+    return this->pending;
+}
+
+void TextureLoader::Finish()
+{
+    while (this->pending > 0)
+        this->process(std::numeric_limits<float>::infinity(), true);
+}
+
+void TextureLoader::process(float budget, bool wait)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // complete the textures whose transfers are done
+    for (std::vector<RequestPtr>::iterator request = this->transferring.begin(); request != this->transferring.end(); )
+    {
+        if (fenceSignaled((*request)->Fence, wait))
+        {
+            this->complete(**request);
+            request = this->transferring.erase(request);
+        }
+        else
+            ++request;
+    }
+    // upload chunks until the budget is spent
+    while (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() < budget)
+    {
+        if (!this->uploading)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (wait)
+                this->decodedOne.wait(lock, [this]() { return !this->decoded.empty() || this->decoding == 0; });
+            if (this->decoded.empty())
+                break;
+            RequestPtr request = this->decoded.front();
+            this->decoded.pop_front();
+            lock.unlock();
+            if (request->Failed)
+            {
+                std::cout << "ERROR::TEXTURE: Failed to load " << request->File << std::endl;
+                this->complete(*request);
+                continue;
+            }
+            if (request->Compressed && !CompressedFormatSupported(request->Texture.Internal_Format))
+            {
+                // decode the image itself instead
+                request->TryKtx = false;
+                lock.lock();
+                this->decodeQueue.push_back(request);
+                ++this->decoding;
+                lock.unlock();
+                this->queued.notify_one();
+                continue;
+            }
+            allocate(*request);
+            this->uploading = request;
+        }
+        if (!this->uploadChunk(*this->uploading, wait))
+            break;
+        if (this->uploading->Level == this->uploading->Levels.size())
+        {
+            this->uploading->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            this->transferring.push_back(this->uploading);
+            this->uploading.reset();
+        }
+    }
+}
+
+void TextureLoader::work()
+{
+    for (;;)
+    {
+        RequestPtr request;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->queued.wait(lock, [this]() { return this->stopping || !this->decodeQueue.empty(); });
+            if (this->stopping)
+                return;
+            request = this->decodeQueue.front();
+            this->decodeQueue.pop_front();
+        }
+        decode(*request);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->decoded.push_back(request);
+            --this->decoding;
+        }
+        this->decodedOne.notify_all();
+    }
+}
+
+void TextureLoader::decode(Request& request)
+{
+    // prefer the block compressed version with mipmaps if it was converted (see CompressTextures)
+    KtxImage image;
+    std::string compressed = request.File.substr(0, request.File.find_last_of('.')) + ".ktx";
+    if (request.TryKtx && ReadKtx(compressed.c_str(), image))
+    {
+        request.Compressed = true;
+        request.Texture.Internal_Format = image.InternalFormat;
+        request.Texture.Image_Format = image.BaseFormat;
+        request.Width = image.Width;
+        request.Height = image.Height;
+        request.Levels = std::move(image.Levels);
+        return;
+    }
+    request.Compressed = false;
+    unsigned int channels = request.Alpha ? 4 : 3;
+    int width, height, fileChannels;
+    unsigned char* data = stbi_load(request.File.c_str(), &width, &height, &fileChannels, channels);
+    if (!data)
+    {
+        request.Failed = true;
+        return;
+    }
+    request.Texture.Internal_Format = request.Alpha ? GL_RGBA : GL_RGB;
+    request.Texture.Image_Format = request.Alpha ? GL_RGBA : GL_RGB;
+    request.Width = width;
+    request.Height = height;
+    request.Levels.assign(1, std::vector<unsigned char>(data, data + static_cast<std::size_t>(width) * height * channels));
+    stbi_image_free(data);
+}
+
+void TextureLoader::allocate(Request& request)
+{
+    Texture2D& texture = request.Texture;
+    unsigned int levels = static_cast<unsigned int>(request.Levels.size());
+    texture.Width = request.Width;
+    texture.Height = request.Height;
+    if (levels > 1 && texture.Filter_Min == GL_LINEAR)
+        texture.Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+    // storage without contents in an object of its own, the chunks fill it in while the texture it
+    // replaces is still drawn
+    glGenTextures(1, &texture.ID);
+    StateCache::BindTexture(GL_TEXTURE_2D, texture.ID);
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        unsigned int width = std::max(request.Width >> level, 1u), height = std::max(request.Height >> level, 1u);
+        if (request.Compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.Internal_Format, width, height, 0, static_cast<GLsizei>(request.Levels[level].size()), NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, texture.Internal_Format, width, height, 0, texture.Image_Format, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.Filter_Max);
+    StateCache::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool TextureLoader::uploadChunk(Request& request, bool wait)
+{
+    // a level is copied in whole rows, of 4x4 blocks if it's block compressed
+    const std::vector<unsigned char>& level = request.Levels[request.Level];
+    unsigned int width = std::max(request.Width >> request.Level, 1u), height = std::max(request.Height >> request.Level, 1u);
+    unsigned int rowHeight = request.Compressed ? 4 : 1;
+    unsigned int rows = (height + rowHeight - 1) / rowHeight;
+    std::size_t rowSize = level.size() / rows;
+    unsigned int count = static_cast<unsigned int>(std::min<std::size_t>(rows - request.Row, std::max<std::size_t>(CHUNK_SIZE / rowSize, 1)));
+    std::size_t size = count * rowSize;
+    // a single row larger than a staging buffer is copied by the driver straight out of the decoded
+    // data instead, the staging buffers keep their size
+    const unsigned char* pixels = level.data() + request.Row * rowSize;
+    bool staged = size <= CHUNK_SIZE;
+    Staging& buffer = this->staging[this->nextStaging];
+    if (staged)
+    {
+        if (buffer.Fence)
+        {
+            if (!fenceSignaled(buffer.Fence, wait))
+                return false;
+            glDeleteSync(buffer.Fence);
+            buffer.Fence = nullptr;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.PBO);
+        void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        std::memcpy(data, pixels, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // the driver copies out of the bound buffer, the offset into it goes where the pixels would
+        pixels = NULL;
+    }
+    unsigned int y = request.Row * rowHeight;
+    unsigned int chunkHeight = std::min(count * rowHeight, height - y);
+    StateCache::BindTexture(GL_TEXTURE_2D, request.Texture.ID);
+    if (request.Compressed)
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, request.Level, 0, y, width, chunkHeight, request.Texture.Internal_Format, static_cast<GLsizei>(size), pixels);
+    else
+    {
+        // rows are tightly packed; the alignment is set back for the other uploads
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, request.Level, 0, y, width, chunkHeight, request.Texture.Image_Format, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    }
+    StateCache::BindTexture(GL_TEXTURE_2D, 0);
+    if (staged)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        buffer.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->nextStaging = (this->nextStaging + 1) % STAGING_BUFFERS;
+    }
+    request.Row += count;
+    if (request.Row == rows)
+    {
+        request.Row = 0;
+        ++request.Level;
+    }
+    return true;
+}
+
+void TextureLoader::complete(Request& request)
+{
+    if (request.Fence)
+    {
+        glDeleteSync(request.Fence);
+        request.Fence = nullptr;
+    }
+    // the decoded data isn't needed anymore
+    request.Levels.clear();
+    request.Levels.shrink_to_fit();
+    --this->pending;
+    // a texture that failed to load keeps its contents, whatever was there before (or nothing)
+    if (request.Failed)
+    {
+        request.Promise.set_exception(std::make_exception_ptr(std::runtime_error("Failed to load " + request.File)));
+        return;
+    }
+    if (request.OnReady)
+        request.OnReady(request.Texture);
+    request.Promise.set_value(request.Texture);
+    // whatever sampled the replaced texture switched over in the callback
+    glDeleteTextures(1, &request.Replaced);
+    // a deleted texture was unbound behind the state cache's back
+    StateCache::Invalidate();
+}
\ No newline at end of file
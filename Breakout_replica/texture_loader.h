@@ -0,0 +1,99 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "texture.h"
+
+
+// TextureLoader loads textures without stalling the render thread. The
+// files are read and decoded (or their KTX versions read) on worker
+// threads; the render thread then copies the pixels into a ring of pixel
+// buffer objects, at most CHUNK_SIZE bytes at a time, from which the
+// driver transfers them into the texture asynchronously. Update does as
+// much of that as fits in a time budget, so a texture loaded during play
+// never costs a frame more than the budget. Every chunk is fenced so its
+// staging buffer isn't reused before the transfer out of it is done, and
+// a texture is ready once the fence after its last chunk has signaled:
+// its callback is called and its future set, both on the render thread.
+// A file that fails to load is reported and the texture it would replace kept;
+// the callback isn't called and the future holds a std::runtime_error.
+//
+// Everything but decoding happens on the thread owning the OpenGL context,
+// which therefore must not wait on a texture's future; it calls Finish.
+class TextureLoader
+{
+public:
+    // most bytes copied into a staging buffer at once; rounded up to a whole row of pixels (or blocks)
+    static const std::size_t  CHUNK_SIZE = 1 << 20;
+    // staging buffers the chunks cycle through
+    static const unsigned int STAGING_BUFFERS = 4;
+    // called on the render thread once a texture is ready
+    typedef std::function<void(const Texture2D&)> Callback;
+    // constructor/destructor, threads is the amount of decoding threads (0 picks one per spare core, at most 4).
+    // Textures still loading when the loader is destroyed are deleted, their futures are never set
+    explicit TextureLoader(unsigned int threads = 0);
+    ~TextureLoader();
+    // starts loading a texture from file, or from the KTX file next to it if there is one the context supports.
+    // It's loaded into a new object with the sampling settings of texture, the texture it replaces: that one
+    // is left alone while the new one loads and deleted once it's ready, right after the callback
+    std::shared_future<Texture2D> Load(const char* file, bool alpha, Callback onReady = nullptr, const Texture2D& texture = Texture2D());
+    // uploads decoded textures for at most budget milliseconds and completes the ones that are ready; returns how many are still loading
+    unsigned int Update(float budget);
+    // blocks until every texture loading is ready
+    void Finish();
+private:
+    struct Request;
+    typedef std::shared_ptr<Request> RequestPtr;
+    struct Staging {
+        unsigned int PBO;
+        GLsync       Fence; // signals once the driver is done reading the buffer
+    };
+    // shared with the workers, guarded by mutex
+    std::mutex              mutex;
+    std::condition_variable queued;      // a request was queued for decoding, or the loader stops
+    std::condition_variable decodedOne;  // a worker finished a request
+    std::deque<RequestPtr>  decodeQueue;
+    std::deque<RequestPtr>  decoded;
+    unsigned int            decoding;    // requests queued for or being decoded
+    bool                    stopping;
+    std::vector<std::thread> workers;
+    // used on the render thread only
+    Staging                 staging[STAGING_BUFFERS];
+    unsigned int            nextStaging;
+    RequestPtr              uploading;   // request whose chunks are being uploaded
+    std::vector<RequestPtr> transferring; // requests whose last chunk was uploaded
+    unsigned int            pending;     // requests not completed yet
+    // uploads and completes requests for at most budget milliseconds, waiting for decoding and transfers if wait is set
+    void process(float budget, bool wait);
+    // loop of a worker thread
+    void work();
+    // reads or decodes the file of a request
+    static void decode(Request& request);
+    // allocates a request's texture with all of its levels
+    static void allocate(Request& request);
+    // uploads the next chunk of a request; returns false if no staging buffer is free (and wait isn't set)
+    bool uploadChunk(Request& request, bool wait);
+    // hands a request's texture to its callback and future, or its failure to the future
+    void complete(Request& request);
+};
+
+#endif
\ No newline at end of file
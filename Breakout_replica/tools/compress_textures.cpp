@@ -0,0 +1,30 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "texture_compressor.h"
+
+#include <iostream>
+
+// the game compiles stb_image into its resource manager, the tool has its own
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// Converts the images of a folder into KTX files (see CompressTextures);
+// building the game runs it on resources/textures. It is a program of its
+// own so the build step doesn't start the game's sound engine or create
+// any of its objects:
+//   compress_textures <dir>
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cout << "usage: compress_textures <dir>" << std::endl;
+        return 1;
+    }
+    return CompressTextures(argv[1]) == 0 ? 0 : 1;
+}
\ No newline at end of file